@@ -0,0 +1,120 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef __TEST_CRYPTO_BLAKE2X_DATA_H__
+#define __TEST_CRYPTO_BLAKE2X_DATA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// in the format of the official KAT files: key 0x00..0x3F, input i % 256 for
+// byte i
+static const size_t blake2bp_keyed_lens[] = {0, 1, 127, 128, 255, 511, 512, 513, 1024, 2047, 2049};
+
+static const uint8_t blake2bp_keyed[11][64] = {
+    {0x9D, 0x94, 0x61, 0x07, 0x3E, 0x4E, 0xB6, 0x40, 0xA2, 0x55, 0x35, 0x7B, 0x83, 0x9F, 0x39, 0x4B,
+     0x83, 0x8C, 0x6F, 0xF5, 0x7C, 0x9B, 0x68, 0x6A, 0x3F, 0x76, 0x10, 0x7C, 0x10, 0x66, 0x72, 0x8F,
+     0x3C, 0x99, 0x56, 0xBD, 0x78, 0x5C, 0xBC, 0x3B, 0xF7, 0x9D, 0xC2, 0xAB, 0x57, 0x8C, 0x5A, 0x0C,
+     0x06, 0x3B, 0x9D, 0x9C, 0x40, 0x58, 0x48, 0xDE, 0x1D, 0xBE, 0x82, 0x1C, 0xD0, 0x5C, 0x94, 0x0A},
+    {0xFF, 0x8E, 0x90, 0xA3, 0x7B, 0x94, 0x62, 0x39, 0x32, 0xC5, 0x9F, 0x75, 0x59, 0xF2, 0x60, 0x35,
+     0x02, 0x9C, 0x37, 0x67, 0x32, 0xCB, 0x14, 0xD4, 0x16, 0x02, 0x00, 0x1C, 0xBB, 0x73, 0xAD, 0xB7,
+     0x92, 0x93, 0xA2, 0xDB, 0xDA, 0x5F, 0x60, 0x70, 0x30, 0x25, 0x14, 0x4D, 0x15, 0x8E, 0x27, 0x35,
+     0x52, 0x95, 0x96, 0x25, 0x1C, 0x73, 0xC0, 0x34, 0x5C, 0xA6, 0xFC, 0xCB, 0x1F, 0xB1, 0xE9, 0x7E},
+    {0x79, 0x26, 0x70, 0x88, 0x59, 0xE6, 0xE2, 0xAB, 0x68, 0xF6, 0x04, 0xDA, 0x69, 0xA9, 0xFB, 0x50,
+     0x87, 0xBB, 0x33, 0xF4, 0xE8, 0xD8, 0x95, 0x73, 0x0E, 0x30, 0x1A, 0xB2, 0xD7, 0xDF, 0x74, 0x8B,
+     0x67, 0xDF, 0x0B, 0x6B, 0x86, 0x22, 0xE5, 0x2D, 0xD5, 0x7D, 0x8D, 0x3A, 0xD8, 0x7D, 0x58, 0x20,
+     0xD4, 0xEC, 0xFD, 0x24, 0x17, 0x8B, 0x2D, 0x2B, 0x78, 0xD6, 0x4F, 0x4F, 0xBD, 0x38, 0x75, 0x82},
+    {0x92, 0x80, 0xF4, 0xD1, 0x15, 0x70, 0x32, 0xAB, 0x31, 0x5C, 0x10, 0x0D, 0x63, 0x62, 0x83, 0xFB,
+     0xF4, 0xFB, 0xA2, 0xFB, 0xAD, 0x0F, 0x8B, 0xC0, 0x20, 0x72, 0x1D, 0x76, 0xBC, 0x1C, 0x89, 0x73,
+     0xCE, 0xD2, 0x88, 0x71, 0xCC, 0x90, 0x7D, 0xAB, 0x60, 0xE5, 0x97, 0x56, 0x98, 0x7B, 0x0E, 0x0F,
+     0x86, 0x7F, 0xA2, 0xFE, 0x9D, 0x90, 0x41, 0xF2, 0xC9, 0x61, 0x80, 0x74, 0xE4, 0x4F, 0xE5, 0xE9},
+    {0x96, 0xFB, 0xCB, 0xB6, 0x0B, 0xD3, 0x13, 0xB8, 0x84, 0x50, 0x33, 0xE5, 0xBC, 0x05, 0x8A, 0x38,
+     0x02, 0x74, 0x38, 0x57, 0x2D, 0x7E, 0x79, 0x57, 0xF3, 0x68, 0x4F, 0x62, 0x68, 0xAA, 0xDD, 0x3A,
+     0xD0, 0x8D, 0x21, 0x76, 0x7E, 0xD6, 0x87, 0x86, 0x85, 0x33, 0x1B, 0xA9, 0x85, 0x71, 0x48, 0x7E,
+     0x12, 0x47, 0x0A, 0xAD, 0x66, 0x93, 0x26, 0x71, 0x6E, 0x46, 0x66, 0x7F, 0x69, 0xF8, 0xD7, 0xE8},
+    {0xEB, 0x7B, 0x7B, 0xB4, 0xD5, 0x21, 0x70, 0x25, 0x70, 0x5E, 0x94, 0x9D, 0x98, 0xDB, 0x93, 0xEE,
+     0x62, 0xE6, 0x4F, 0x6F, 0xB9, 0xE6, 0xF4, 0x51, 0x08, 0xA5, 0xF7, 0xEB, 0xE2, 0x90, 0x81, 0x61,
+     0x29, 0x4B, 0x0E, 0x8C, 0x90, 0x4A, 0xFA, 0x9D, 0x57, 0xC5, 0x06, 0xE9, 0xDA, 0x3B, 0x02, 0x80,
+     0x6F, 0xD5, 0x76, 0x7A, 0xE5, 0x54, 0x98, 0xEB, 0x3B, 0xB8, 0xCD, 0x7F, 0x09, 0x1B, 0x57, 0x2D},
+    {0x14, 0xBA, 0x32, 0xC1, 0xC8, 0x0B, 0xB3, 0x2C, 0x82, 0x82, 0xAA, 0x53, 0xF3, 0x41, 0xF4, 0x5D,
+     0xAA, 0xBD, 0xA1, 0x2B, 0xDA, 0x41, 0xF7, 0xAD, 0x8E, 0xC7, 0x5B, 0xAA, 0x74, 0x3A, 0x41, 0xAD,
+     0xF2, 0x37, 0x6A, 0xD3, 0xDE, 0x32, 0xFB, 0x57, 0x6D, 0x3E, 0xFD, 0xCA, 0xDF, 0x3F, 0x59, 0xD2,
+     0x5B, 0x40, 0xB9, 0x15, 0x68, 0x1C, 0xC9, 0x0D, 0xEE, 0x3A, 0x9B, 0x2C, 0xB0, 0x20, 0x61, 0xEA},
+    {0x2D, 0x9A, 0xF8, 0x50, 0x3C, 0x1B, 0x10, 0x7A, 0xEC, 0xE8, 0xEC, 0xC7, 0x3F, 0x2C, 0x2A, 0x6E,
+     0xCF, 0xE3, 0xDE, 0xF9, 0x43, 0xAB, 0x27, 0x7B, 0xB3, 0x32, 0x36, 0x43, 0xB8, 0xBB, 0xD3, 0x36,
+     0x31, 0xE3, 0x4D, 0x0F, 0x09, 0x5A, 0x4A, 0xFB, 0x01, 0x93, 0xB2, 0xD4, 0x4B, 0xCD, 0x11, 0x38,
+     0x3D, 0x60, 0xAD, 0x02, 0x04, 0x72, 0xB1, 0x9F, 0x28, 0xF3, 0xED, 0xF3, 0xDB, 0xCB, 0xDC, 0xDA},
+    {0x86, 0x8A, 0x4B, 0xE4, 0x29, 0xBF, 0xE1, 0x26, 0x79, 0x6F, 0x52, 0x80, 0x04, 0xB9, 0x9B, 0xB7,
+     0x9B, 0x3C, 0xB1, 0x49, 0x77, 0x1E, 0x8D, 0x9F, 0x0D, 0x96, 0x2E, 0x39, 0xD5, 0x8D, 0xB1, 0xC2,
+     0x8D, 0x42, 0xDC, 0xF2, 0x3E, 0xAE, 0xD7, 0x36, 0x1F, 0xE1, 0xAE, 0x8B, 0xC1, 0x82, 0xA7, 0xE0,
+     0x36, 0x35, 0x2B, 0xF5, 0x71, 0x97, 0x6D, 0x2B, 0xFD, 0x63, 0xE9, 0x2D, 0x92, 0x0B, 0xB4, 0x9A},
+    {0x62, 0x99, 0xDB, 0xE0, 0xF1, 0x0D, 0xDA, 0xCD, 0x95, 0xD8, 0x79, 0x92, 0x49, 0x76, 0xDB, 0xCF,
+     0x88, 0x63, 0xAA, 0xC5, 0xF3, 0xFC, 0xB8, 0x73, 0xAC, 0x7A, 0xB2, 0x39, 0x7C, 0xB8, 0x09, 0xCB,
+     0x66, 0xD6, 0x66, 0xC3, 0x31, 0x67, 0xA2, 0xC6, 0x1F, 0x24, 0xA6, 0xA9, 0xDA, 0x17, 0x78, 0x26,
+     0x9E, 0x44, 0xDD, 0xE1, 0x52, 0xD1, 0x75, 0xA9, 0x6D, 0x3F, 0xB7, 0xBB, 0xAF, 0x79, 0xB8, 0xBC},
+    {0x8F, 0x9D, 0x23, 0xFE, 0x78, 0xAF, 0x91, 0xF8, 0xD6, 0xA7, 0xAE, 0xC6, 0x05, 0xC3, 0x09, 0x0A,
+     0xA9, 0xB0, 0x96, 0xA0, 0x70, 0x8D, 0xBB, 0x63, 0xC6, 0xB5, 0x9F, 0x2E, 0x49, 0xDE, 0x12, 0x1B,
+     0x53, 0x06, 0x41, 0x78, 0xD1, 0xD3, 0x22, 0xF2, 0x3F, 0xEF, 0x93, 0xF3, 0x1F, 0xBC, 0xA9, 0xD4,
+     0x6E, 0x2D, 0x31, 0xF9, 0xDC, 0x6D, 0x41, 0x6F, 0x2C, 0xF3, 0xDE, 0x6A, 0x85, 0x96, 0xF1, 0x96}};
+
+// key 0x00..0x3F, input 0x00..0xFF
+static const uint8_t blake2xb_keyed_1[1] = {
+    0x64};
+
+static const uint8_t blake2xb_keyed_32[32] = {
+    0x29, 0xF6, 0xBB, 0x55, 0xDE, 0x7F, 0x88, 0x68, 0xE0, 0x53, 0x17, 0x6C, 0x87, 0x8C, 0x9F, 0xE6,
+    0xC2, 0x05, 0x5C, 0x4C, 0x54, 0x13, 0xB5, 0x1A, 0xB0, 0x38, 0x6C, 0x27, 0x7F, 0xDB, 0xAC, 0x75};
+
+static const uint8_t blake2xb_keyed_64[64] = {
+    0x43, 0x24, 0x56, 0x1D, 0x76, 0xC3, 0x70, 0xEF, 0x35, 0xAC, 0x36, 0xA4, 0xAD, 0xF8, 0xF3, 0x77,
+    0x3A, 0x50, 0xD8, 0x65, 0x04, 0xBD, 0x28, 0x4F, 0x71, 0xF7, 0xCE, 0x9E, 0x2B, 0xC4, 0xC1, 0xF1,
+    0xD3, 0x4A, 0x7F, 0xB2, 0xD6, 0x75, 0x61, 0xD1, 0x01, 0x95, 0x5D, 0x44, 0x8B, 0x67, 0x57, 0x7E,
+    0xB3, 0x0D, 0xFE, 0xE9, 0x6A, 0x95, 0xC7, 0xF9, 0x21, 0xEF, 0x53, 0xE2, 0x0B, 0xE8, 0xBC, 0x44};
+
+static const uint8_t blake2xb_keyed_65[65] = {
+    0x78, 0xF0, 0xED, 0x6E, 0x22, 0x0B, 0x3D, 0xA3, 0xCC, 0x93, 0x81, 0x56, 0x3B, 0x2F, 0x72, 0xC8,
+    0xDC, 0x83, 0x0C, 0xB0, 0xF3, 0x9A, 0x48, 0xC6, 0xAE, 0x47, 0x9A, 0x6A, 0x78, 0xDC, 0xFA, 0x94,
+    0x00, 0x26, 0x31, 0xDE, 0xC4, 0x67, 0xE9, 0xE9, 0xB4, 0x7C, 0xC8, 0xF0, 0x88, 0x7E, 0xB6, 0x80,
+    0xE3, 0x40, 0xAE, 0xC3, 0xEC, 0x00, 0x9D, 0x4A, 0x33, 0xD2, 0x41, 0x53, 0x3C, 0x76, 0xC8, 0xCA,
+    0x8C};
+
+static const uint8_t blake2xb_keyed_128[128] = {
+    0x2D, 0x7D, 0xC8, 0x0C, 0x19, 0xA1, 0xD1, 0x2D, 0x5F, 0xE3, 0x96, 0x35, 0x69, 0x54, 0x7A, 0x5D,
+    0x1D, 0x3E, 0x82, 0x1E, 0x6F, 0x06, 0xC5, 0xD5, 0xE2, 0xC0, 0x94, 0x01, 0xF9, 0x46, 0xC9, 0xF7,
+    0xE1, 0x3C, 0xD0, 0x19, 0xF2, 0xF9, 0xA8, 0x78, 0xB6, 0x2D, 0xD8, 0x50, 0x45, 0x3B, 0x62, 0x94,
+    0xB9, 0x9C, 0xCA, 0xA0, 0x68, 0xE5, 0x42, 0x99, 0x35, 0x24, 0xB0, 0xF6, 0x38, 0x32, 0xD4, 0x8E,
+    0x86, 0x5B, 0xE3, 0x1E, 0x8E, 0xC1, 0xEE, 0x10, 0x3C, 0x71, 0x83, 0x40, 0xC9, 0x04, 0xB3, 0x2E,
+    0xFB, 0x69, 0x17, 0x0B, 0x67, 0xF0, 0x38, 0xD5, 0x0A, 0x32, 0x52, 0x79, 0x4B, 0x1B, 0x40, 0x76,
+    0xC0, 0x62, 0x06, 0x21, 0xAB, 0x3D, 0x91, 0x21, 0x5D, 0x55, 0xFF, 0xEA, 0x99, 0xF2, 0x3D, 0x54,
+    0xE1, 0x61, 0xA9, 0x0D, 0x8D, 0x49, 0x02, 0xFD, 0xA5, 0x93, 0x1D, 0x9F, 0x6A, 0x27, 0x14, 0x6A};
+
+static const uint8_t blake2xb_keyed_256[256] = {
+    0x1E, 0x9B, 0x2C, 0x45, 0x4E, 0x9D, 0xE3, 0xA2, 0xD7, 0x23, 0xD8, 0x50, 0x33, 0x10, 0x37, 0xDB,
+    0xF5, 0x41, 0x33, 0xDB, 0xE2, 0x74, 0x88, 0xFF, 0x75, 0x7D, 0xD2, 0x55, 0x83, 0x3A, 0x27, 0xD8,
+    0xEB, 0x8A, 0x12, 0x8A, 0xD1, 0x2D, 0x09, 0x78, 0xB6, 0x88, 0x4E, 0x25, 0x73, 0x70, 0x86, 0xA7,
+    0x04, 0xFB, 0x28, 0x9A, 0xAA, 0xCC, 0xF9, 0x30, 0xD5, 0xB5, 0x82, 0xAB, 0x4D, 0xF1, 0xF5, 0x5F,
+    0x0C, 0x42, 0x9B, 0x68, 0x75, 0xED, 0xEC, 0x3F, 0xE4, 0x54, 0x64, 0xFA, 0x74, 0x16, 0x4B, 0xE0,
+    0x56, 0xA5, 0x5E, 0x24, 0x3C, 0x42, 0x22, 0xC5, 0x86, 0xBE, 0xC5, 0xB1, 0x8F, 0x39, 0x03, 0x6A,
+    0xA9, 0x03, 0xD9, 0x81, 0x80, 0xF2, 0x4F, 0x83, 0xD0, 0x9A, 0x45, 0x4D, 0xFA, 0x1E, 0x03, 0xA6,
+    0x0E, 0x6A, 0x3B, 0xA4, 0x61, 0x3E, 0x99, 0xC3, 0x5F, 0x87, 0x4D, 0x79, 0x01, 0x74, 0xEE, 0x48,
+    0xA5, 0x57, 0xF4, 0xF0, 0x21, 0xAD, 0xE4, 0xD1, 0xB2, 0x78, 0xD7, 0x99, 0x7E, 0xF0, 0x94, 0x56,
+    0x9B, 0x37, 0xB3, 0xDB, 0x05, 0x05, 0x95, 0x1E, 0x9E, 0xE8, 0x40, 0x0A, 0xDA, 0xEA, 0x27, 0x5C,
+    0x6D, 0xB5, 0x1B, 0x32, 0x5E, 0xE7, 0x30, 0xC6, 0x9D, 0xF9, 0x77, 0x45, 0xB5, 0x56, 0xAE, 0x41,
+    0xCD, 0x98, 0x74, 0x1E, 0x28, 0xAA, 0x3A, 0x49, 0x54, 0x45, 0x41, 0xEE, 0xB3, 0xDA, 0x1B, 0x1E,
+    0x8F, 0xA4, 0xE8, 0xE9, 0x10, 0x0D, 0x66, 0xDD, 0x0C, 0x7F, 0x5E, 0x2C, 0x27, 0x1B, 0x1E, 0xCC,
+    0x07, 0x7D, 0xE7, 0x9C, 0x46, 0x2B, 0x9F, 0xE4, 0xC2, 0x73, 0x54, 0x3E, 0xCD, 0x82, 0xA5, 0xBE,
+    0xA6, 0x3C, 0x5A, 0xCC, 0x01, 0xEC, 0xA5, 0xFB, 0x78, 0x0C, 0x7D, 0x7C, 0x8C, 0x9F, 0xE2, 0x08,
+    0xAE, 0x8B, 0xD5, 0x0C, 0xAD, 0x17, 0x69, 0x69, 0x3D, 0x92, 0xC6, 0xC8, 0x64, 0x9D, 0x20, 0xD8};
+
+static const struct {
+  size_t len;
+  const uint8_t *out;
+} blake2xb_keyed[] = {
+    {1, blake2xb_keyed_1},
+    {32, blake2xb_keyed_32},
+    {64, blake2xb_keyed_64},
+    {65, blake2xb_keyed_65},
+    {128, blake2xb_keyed_128},
+    {256, blake2xb_keyed_256}};
+
+#endif
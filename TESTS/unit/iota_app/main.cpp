@@ -10,13 +10,28 @@
 #include "unity/unity.h"
 #include "utest/utest.h"
 
+#include "blake2b-backend.h"
+#include "blake2b-mb.h"
 #include "blake2b_data.h"
+#include "blake2x_data.h"
+#include "clientpp/batchPublisher.h"
+#include "clientpp/hexCodec.h"
+#include "clientpp/iotaAPI.h"
+#include "clientpp/jsonWriter.h"
+#include "clientpp/messageWriter.h"
+#include "clientpp/powEngine.h"
 #include "core/address.h"
 #include "core/models/message.h"
 #include "core/models/payloads/transaction.h"
 #include "core/utils/byte_buffer.h"
 #include "crypto/iota_crypto.h"
+#include "dnsCache.h"
+#include "ed25519.h"
 #include "httpClient.h"
+#include "httpMulti.h"
+#include "httpRetry.h"
+#include "httpWriter.h"
+#include "nodePool.h"
 #include "main_config.h"
 
 using namespace utest::v1;
@@ -35,6 +50,763 @@ static control_t test_http_client(const size_t call_count) {
   return CaseNext;
 }
 
+static control_t test_http_keep_alive(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  httpClient client;
+  client.set_keep_alive(true);
+  TEST_ASSERT(client.get("/api/v1/info") > 0);
+  TEST_ASSERT(client.get("/api/v1/tips") > 0);
+  // the second request goes over the first connection
+  TEST_ASSERT_EQUAL_UINT32(2, client.stats().requests);
+  TEST_ASSERT_EQUAL_UINT32(1, client.stats().reused);
+  TEST_ASSERT_EQUAL_UINT32(1, client.stats().handshakes);
+
+  client.set_keep_alive(false);
+  TEST_ASSERT(client.get("/api/v1/info") > 0);
+  TEST_ASSERT(client.get("/api/v1/info") > 0);
+  TEST_ASSERT_EQUAL_UINT32(3, client.stats().handshakes);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+typedef struct {
+  Semaphore done;
+  int ret;
+  int status;
+} async_result_t;
+
+static void async_done(async_result_t *res, httpClient *client, int ret) {
+  res->ret = ret;
+  res->status = client->response_status_code();
+  res->done.release();
+}
+
+static control_t test_http_async(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  EventQueue queue;
+  Thread thread(osPriorityNormal, HTTP_THREAD_STACK_SIZE);
+  thread.start(callback(&queue, &EventQueue::dispatch_forever));
+
+  httpClient client;
+  async_result_t res = {};
+  // no event queue yet
+  TEST_ASSERT_EQUAL_INT(-1, client.get_async("/api/v1/info",
+                                             callback(async_done, &res)));
+  client.set_event_queue(&queue);
+  client.set_keep_alive(true);
+  TEST_ASSERT_EQUAL_INT(0, client.get_async("/api/v1/info",
+                                            callback(async_done, &res)));
+  // one request at a time
+  TEST_ASSERT_EQUAL_INT(-1, client.get_async("/api/v1/tips",
+                                             callback(async_done, &res)));
+  TEST_ASSERT(res.done.try_acquire_for(30s));
+  TEST_ASSERT(res.ret > 0);
+  TEST_ASSERT_EQUAL_INT(200, res.status);
+  TEST_ASSERT_FALSE(client.busy());
+
+  // the second request reuses the connection
+  TEST_ASSERT_EQUAL_INT(0, client.get_async("/api/v1/tips",
+                                            callback(async_done, &res)));
+  TEST_ASSERT(res.done.try_acquire_for(30s));
+  TEST_ASSERT(res.ret > 0);
+  TEST_ASSERT_EQUAL_UINT32(1, client.stats().reused);
+
+  queue.break_dispatch();
+  thread.join();
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static int count_sink(void *ctx, char const *at, size_t length) {
+  *static_cast<size_t *>(ctx) += length;
+  return 0;
+}
+
+static control_t test_http_body_sink(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  httpClient client;
+  size_t streamed = 0;
+  TEST_ASSERT(client.get("/api/v1/info", count_sink, &streamed) > 0);
+  // streamed chunks are not buffered
+  TEST_ASSERT(streamed > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, client.response_data().length());
+
+  TEST_ASSERT(client.get("/api/v1/info") > 0);
+  TEST_ASSERT(client.response_data().length() > 0);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+// chunked and close-delimited bodies read to completion, truncated ones
+// rejected, from canned responses in small reads
+static control_t test_http_framing(const size_t call_count) {
+  static char const chunked[] = "HTTP/1.1 200 OK\r\n"
+                                "Transfer-Encoding: chunked\r\n\r\n"
+                                "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n";
+  static char const closed[] = "HTTP/1.1 200 OK\r\n"
+                               "Connection: close\r\n\r\n"
+                               "until the connection closes";
+  static char const short_length[] = "HTTP/1.1 200 OK\r\n"
+                                     "Content-Length: 20\r\n\r\n"
+                                     "short";
+  static char const short_chunked[] = "HTTP/1.1 200 OK\r\n"
+                                      "Transfer-Encoding: chunked\r\n\r\n"
+                                      "5\r\nhel";
+  httpClient client;
+
+  // two chunks and the last, empty one
+  TEST_ASSERT_EQUAL_INT(
+      11, client.parse_response(chunked, sizeof(chunked) - 1, 7));
+  TEST_ASSERT_EQUAL_STRING("hello world", client.response_data().c_str());
+  TEST_ASSERT_EQUAL_UINT32(3, client.stats().chunks);
+
+  TEST_ASSERT_EQUAL_INT(27, client.parse_response(closed, sizeof(closed) - 1, 5));
+  TEST_ASSERT_EQUAL_STRING("until the connection closes",
+                           client.response_data().c_str());
+  TEST_ASSERT_EQUAL_UINT32(3, client.stats().chunks);
+  // the server closes with close_notify or with a plain TCP FIN, a broken
+  // record is an error
+  TEST_ASSERT_EQUAL_INT(27, client.parse_response(
+                                closed, sizeof(closed) - 1, 5,
+                                MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY));
+  TEST_ASSERT_EQUAL_INT(27, client.parse_response(closed, sizeof(closed) - 1,
+                                                  5, MBEDTLS_ERR_SSL_CONN_EOF));
+  TEST_ASSERT_EQUAL_INT(-1, client.parse_response(
+                                closed, sizeof(closed) - 1, 5,
+                                MBEDTLS_ERR_SSL_INVALID_MAC));
+  TEST_ASSERT_EQUAL_INT(0, tlsTransport::read_result(MBEDTLS_ERR_SSL_CONN_EOF,
+                                                     false));
+  TEST_ASSERT_EQUAL_INT(NSAPI_ERROR_WOULD_BLOCK,
+                        tlsTransport::read_result(MBEDTLS_ERR_SSL_WANT_READ,
+                                                  false));
+
+  // the connection closes before the body is complete
+  TEST_ASSERT_EQUAL_INT(
+      -1, client.parse_response(short_length, sizeof(short_length) - 1, 5));
+  TEST_ASSERT_EQUAL_INT(
+      -1, client.parse_response(short_chunked, sizeof(short_chunked) - 1, 5));
+  TEST_ASSERT_EQUAL_UINT32(4, client.stats().chunks);
+  return CaseNext;
+}
+
+static control_t test_http_pipeline(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  httpClient client;
+  vector<string> paths = {"/api/v1/info", "/api/v1/tips", "/api/v1/info",
+                          "/api/v1/tips", "/api/v1/info"};
+  vector<http_result_t> results;
+  TEST_ASSERT(client.pipeline(paths, results) == 0);
+  TEST_ASSERT_EQUAL_UINT32(paths.size(), results.size());
+  for (size_t i = 0; i < results.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT(200, results[i].status_code);
+    // responses are matched to their requests
+    bool is_tips = results[i].body.find("tipMessageIds") != string::npos;
+    TEST_ASSERT_EQUAL(paths[i] == "/api/v1/tips", is_tips);
+  }
+  printf("pipelined %u, handshakes %u\n", client.stats().pipelined,
+         client.stats().handshakes);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_http_multi(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  vector<http_request_t> reqs;
+  for (int i = 0; i < 6; i++) {
+    reqs.push_back({HTTP_GET, i % 2 ? "/api/v1/tips" : "/api/v1/info", ""});
+  }
+  vector<http_result_t> results;
+
+  // warm up both paths so that handshakes are not measured
+  httpMulti single(1);
+  httpMulti multi(HTTP_CONNECTIONS);
+  TEST_ASSERT(single.run(reqs, results) == 0);
+  TEST_ASSERT(multi.run(reqs, results) == 0);
+
+  Timer t;
+  t.start();
+  TEST_ASSERT(single.run(reqs, results) == 0);
+  auto seq_ms = chrono::duration_cast<chrono::milliseconds>(t.elapsed_time());
+  t.reset();
+  TEST_ASSERT(multi.run(reqs, results) == 0);
+  auto par_ms = chrono::duration_cast<chrono::milliseconds>(t.elapsed_time());
+  t.stop();
+
+  for (auto &res : results) {
+    TEST_ASSERT_EQUAL_UINT(200, res.status_code);
+    TEST_ASSERT(res.body.length() > 0);
+  }
+  printf("%u requests: 1 connection %lld ms, %u connections %lld ms\n",
+         reqs.size(), seq_ms.count(), multi.connections(), par_ms.count());
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_http_writer(const size_t call_count) {
+  char const *const exp_head = "POST /api/v1/messages HTTP/1.1\r\n"
+                               "Host: localhost\r\n"
+                               "Content-Type: application/json\r\n"
+                               "User-Agent: IOTA CClient\r\n"
+                               "Accept: */*\r\n"
+                               "Connection: keep-alive\r\n"
+                               "Content-Length: 1024\r\n\r\n";
+  char buf[256] = {};
+  http_head_t head = {HTTP_POST,          "localhost", "/api/v1/messages",
+                      "application/json", 1024,        true};
+
+#if MBED_HEAP_STATS_ENABLED
+  mbed_stats_heap_t heap_before = {}, heap_after = {};
+  mbed_stats_heap_get(&heap_before);
+#endif
+  int len = http_write_head(&head, buf, sizeof(buf));
+#if MBED_HEAP_STATS_ENABLED
+  mbed_stats_heap_get(&heap_after);
+  TEST_ASSERT_EQUAL_UINT32(heap_before.alloc_cnt, heap_after.alloc_cnt);
+#endif
+  TEST_ASSERT_EQUAL_INT(strlen(exp_head), len);
+  TEST_ASSERT_EQUAL_MEMORY(exp_head, buf, len);
+  // too small buffer
+  TEST_ASSERT(http_write_head(&head, buf, 64) == -1);
+
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  // a request with a small body is a single TLS record, the node rejects the
+  // empty message without retries
+  httpClient client;
+  client.post("/api/v1/messages", "{}");
+  TEST_ASSERT_EQUAL_INT(400, client.response_status_code());
+  TEST_ASSERT_EQUAL_UINT32(1, client.stats().writes);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_http_retry(const size_t call_count) {
+  http_retry_t policy = {3, 500, 8000};
+  // doubled per attempt up to the cap, with at least half of it waited
+  for (unsigned attempt = 0; attempt < 8; attempt++) {
+    uint32_t backoff = attempt < 4 ? 500 << attempt : 8000;
+    for (uint32_t rnd = 0; rnd < 1000; rnd += 37) {
+      uint32_t delay = http_backoff_ms(&policy, attempt, rnd * 2654435761u);
+      TEST_ASSERT(delay >= backoff / 2 && delay <= backoff);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(8000, http_backoff_ms(&policy, 40, 4000));
+
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  // no time to connect, nor to wait for a retry
+  httpClient client;
+  client.set_timeouts({5000, 10000, 10000, 1});
+  TEST_ASSERT(client.get("/api/v1/info") < 0);
+  TEST_ASSERT_EQUAL_UINT32(1, client.stats().total_timeouts);
+  TEST_ASSERT_EQUAL_UINT32(0, client.stats().retries);
+
+  client.set_timeouts({HTTP_CONNECT_TIMEOUT, HTTP_HANDSHAKE_TIMEOUT,
+                       HTTP_FIRST_BYTE_TIMEOUT, HTTP_TOTAL_TIMEOUT});
+  TEST_ASSERT(client.get("/api/v1/info") > 0);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_tips_cache(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  iotaAPI iota;
+  string msg_id;
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, iota.tipsAge());
+  // the first message fetches tips, the second one reuses them
+  TEST_ASSERT_EQUAL_INT(0, iota.sendIndexation("iota_test", "tips", msg_id));
+  TEST_ASSERT_EQUAL_INT(0, iota.sendIndexation("iota_test", "tips", msg_id));
+  TEST_ASSERT_EQUAL_UINT32(1, iota.tipsStats().misses);
+  TEST_ASSERT_EQUAL_UINT32(1, iota.tipsStats().hits);
+  TEST_ASSERT(iota.tipsAge() < TIPS_MAX_AGE);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_submit_modes(const size_t call_count) {
+  const iota_submit_mode_t modes[] = {
+      IOTA_SUBMIT_TIPS, IOTA_SUBMIT_NODE_PARENTS, IOTA_SUBMIT_MINIMAL};
+  const char *const names[] = {"tips", "node parents", "minimal"};
+  const uint32_t msgs = 3;
+  uint32_t requests[3] = {}, tx[3] = {};
+
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  // round trips and bytes per message for each mode
+  for (size_t m = 0; m < 3; m++) {
+    iotaAPI iota;
+    string msg_id;
+    iota.setSubmitMode(modes[m]);
+    for (uint32_t i = 0; i < msgs; i++) {
+      TEST_ASSERT_EQUAL_INT(0,
+                            iota.sendIndexation("iota_test", "mode", msg_id));
+    }
+    const http_stats_t &st = iota.httpStats();
+    requests[m] = st.requests;
+    tx[m] = st.tx_bytes;
+    printf("%s: %lu.%02lu requests, %lu bytes sent, %lu received per message\n",
+           names[m], st.requests / msgs, (st.requests * 100 / msgs) % 100,
+           st.tx_bytes / msgs, st.rx_bytes / msgs);
+  }
+  // a single request per message, no parents sent
+  TEST_ASSERT_EQUAL_UINT32(msgs, requests[1]);
+  TEST_ASSERT(requests[1] < requests[0]);
+  TEST_ASSERT(tx[1] < tx[0]);
+  TEST_ASSERT(tx[2] < tx[1]);
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static void hex_byte_loop(char *hex, uint8_t const *bin, size_t len) {
+  static const char hex_digits[] = "0123456789ABCDEF";
+  for (size_t i = 0; i < len; i++) {
+    hex[2 * i] = hex_digits[bin[i] >> 4];
+    hex[2 * i + 1] = hex_digits[bin[i] & 15];
+  }
+}
+
+static control_t test_hex_codec(const size_t call_count) {
+  const size_t max_len = 32768;
+  uint8_t exp_bin[] = {0x00, 0x7d, 0xab, 0xd0, 0x08, 0xff};
+  uint8_t bin[8] = {};
+  char hex[16] = {};
+
+  TEST_ASSERT_EQUAL_INT(12, hex_encode(hex, sizeof(hex), exp_bin, 6));
+  TEST_ASSERT_EQUAL_MEMORY("007dabd008ff", hex, 12);
+  TEST_ASSERT_EQUAL_INT(6, hex_decode(bin, sizeof(bin), "007DABd008fF", 12));
+  TEST_ASSERT_EQUAL_MEMORY(exp_bin, bin, 6);
+  // odd length, not a hex digit, too small buffers
+  TEST_ASSERT(hex_decode(bin, sizeof(bin), "007", 3) == -1);
+  TEST_ASSERT(hex_decode(bin, sizeof(bin), "0g", 2) == -1);
+  TEST_ASSERT(hex_decode(bin, 2, "007dab", 6) == -1);
+  TEST_ASSERT(hex_encode(hex, 11, exp_bin, 6) == -1);
+
+  uint8_t *in = new uint8_t[max_len];
+  uint8_t *out = new uint8_t[max_len];
+  char *text = new char[2 * max_len];
+  TEST_ASSERT(in && out && text);
+  for (size_t i = 0; i < max_len; i++) {
+    in[i] = i * 131 + 7;
+  }
+
+  // throughput from an ID to a full message payload
+  printf("hex kernel: %s\n", hex_kernel());
+  for (size_t len = 32; len <= max_len; len *= 4) {
+    const int rounds = max_len * 4 / len;
+    Timer t;
+    t.start();
+    for (int i = 0; i < rounds; i++) {
+      hex_byte_loop(text, in, len);
+    }
+    auto loop_us = t.elapsed_time().count();
+    t.reset();
+    for (int i = 0; i < rounds; i++) {
+      hex_encode(text, 2 * max_len, in, len);
+    }
+    auto enc_us = t.elapsed_time().count();
+    t.reset();
+    for (int i = 0; i < rounds; i++) {
+      TEST_ASSERT_EQUAL_INT(len, hex_decode(out, max_len, text, 2 * len));
+    }
+    auto dec_us = t.elapsed_time().count();
+    t.stop();
+    TEST_ASSERT_EQUAL_MEMORY(in, out, len);
+    printf("%5u B: encode %lld us, byte loop %lld us, decode %lld us per "
+           "%d rounds\n",
+           len, enc_us, loop_us, dec_us, rounds);
+  }
+
+  delete[] in;
+  delete[] out;
+  delete[] text;
+  return CaseNext;
+}
+
+static control_t test_json_writer(const size_t call_count) {
+  char const *const exp_msg =
+      "{\"networkId\":\"\",\"parentMessageIds\":["
+      "\"7dabd008324378d65e607975e9f1740aa8b2f624b9e25248370454dcd07027f3\"],"
+      "\"payload\":{\"type\":2,\"index\":\"696f74612e63\",\"data\":"
+      "\"426172\"},\"nonce\":\"\"}";
+  vector<string> tips = {
+      "7dabd008324378d65e607975e9f1740aa8b2f624b9e25248370454dcd07027f3"};
+  char buf[512] = {};
+  json_writer_t w;
+
+  // escaping and separators
+  json_writer_init(&w, buf, sizeof(buf));
+  json_begin_object(&w);
+  json_write_key(&w, "s");
+  json_write_string(&w, "a\"b\\\n", 5);
+  json_write_key(&w, "a");
+  json_begin_array(&w);
+  json_write_uint(&w, 0);
+  json_write_uint(&w, 18446744073709551615ull);
+  json_end_array(&w);
+  json_end_object(&w);
+  int len = json_writer_finish(&w);
+  char const *const exp_json =
+      "{\"s\":\"a\\\"b\\\\\\u000a\",\"a\":[0,18446744073709551615]}";
+  TEST_ASSERT_EQUAL_INT(strlen(exp_json), len);
+  TEST_ASSERT_EQUAL_MEMORY(exp_json, buf, len);
+
+  iotaAPI iota;
+  iota.setSubmitMode(IOTA_SUBMIT_TIPS);
+#if MBED_HEAP_STATS_ENABLED
+  mbed_stats_heap_t heap_before = {}, heap_after = {};
+  mbed_stats_heap_get(&heap_before);
+#endif
+  len = iota.composeIndexation("iota.c", "Bar", tips, buf, sizeof(buf));
+#if MBED_HEAP_STATS_ENABLED
+  mbed_stats_heap_get(&heap_after);
+  // nothing allocated, nothing left behind
+  TEST_ASSERT_EQUAL_UINT32(heap_before.alloc_cnt, heap_after.alloc_cnt);
+  TEST_ASSERT_EQUAL_UINT32(heap_before.current_size, heap_after.current_size);
+#endif
+  TEST_ASSERT_EQUAL_INT(strlen(exp_msg), len);
+  TEST_ASSERT_EQUAL_MEMORY(exp_msg, buf, len);
+  // too small buffer
+  TEST_ASSERT(iota.composeIndexation("iota.c", "Bar", tips, buf, 64) == -1);
+  // at most IOTA_MAX_PARENTS parents after 91 bytes of keys and braces,
+  // within the overhead a batch leaves for them
+  tips.resize(IOTA_MAX_PARENTS + 2, tips[0]);
+  char *big = new char[4096];
+  len = iota.composeIndexation("", "", tips, big, 4096);
+  TEST_ASSERT_EQUAL_INT(91 + IOTA_MAX_PARENTS * IOTA_JSON_PARENT_BYTES - 1,
+                        len);
+  TEST_ASSERT(len <= IOTA_MESSAGE_OVERHEAD);
+  delete[] big;
+  return CaseNext;
+}
+
+static control_t test_message_format(const size_t call_count) {
+  const char *const names[] = {"json", "binary"};
+  const int rounds = 100;
+  vector<string> tips = {
+      "7dabd008324378d65e607975e9f1740aa8b2f624b9e25248370454dcd07027f3",
+      "9f5066de0e3225f062e9ac8c285306f56815677fe5d1db0bbccecfc8f7f1e82c",
+      "ccf9bf6b76a2659f332e17bfdc20f278ce25bc45e807e89cc2ab526cd2101c52",
+      "fe63a9194eadb45e456a3c618d970119dbcac25221dbf5f53e5a838ef6ef518a"};
+  string data(512, 'x');
+  uint8_t buf[2048] = {};
+  int len[2] = {}, allocs[2] = {};
+
+  iotaAPI iota;
+  iota.setSubmitMode(IOTA_SUBMIT_TIPS);
+  // parents are sorted, the first byte of each ID in order
+  TEST_ASSERT_EQUAL_INT(4 * 32 + 9 + 12 + 10 + 9 + 512,
+                        iota.serializeIndexation("iota_test", data, tips, buf,
+                                                 sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT8(4, buf[8]);
+  TEST_ASSERT_EQUAL_HEX8(0x7d, buf[9]);
+  TEST_ASSERT_EQUAL_HEX8(0xfe, buf[9 + 3 * 32]);
+  TEST_ASSERT(iota.serializeIndexation("iota_test", data, tips, buf, 256) ==
+              -1);
+
+  // encoded size, heap allocations and CPU time per message
+  for (int f = 0; f < 2; f++) {
+#if MBED_HEAP_STATS_ENABLED
+    mbed_stats_heap_t heap_before = {}, heap_after = {};
+    mbed_stats_heap_get(&heap_before);
+#endif
+    Timer t;
+    t.start();
+    for (int i = 0; i < rounds; i++) {
+      if (f == 0) {
+        len[f] = iota.composeIndexation("iota_test", data, tips, (char *)buf,
+                                        sizeof(buf));
+      } else {
+        len[f] = iota.serializeIndexation("iota_test", data, tips, buf,
+                                          sizeof(buf));
+      }
+    }
+    t.stop();
+#if MBED_HEAP_STATS_ENABLED
+    mbed_stats_heap_get(&heap_after);
+    allocs[f] = (heap_after.alloc_cnt - heap_before.alloc_cnt) / rounds;
+#endif
+    printf("%s: %d bytes, %d allocations, %lld us per message\n", names[f],
+           len[f], allocs[f], t.elapsed_time().count() / rounds);
+  }
+  TEST_ASSERT(len[1] * 2 < len[0]);
+  TEST_ASSERT_EQUAL_INT(0, allocs[0]);
+  TEST_ASSERT_EQUAL_INT(0, allocs[1]);
+
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  // a message the node completes goes out as JSON, the data hex encoded
+  iotaAPI node;
+  string msg_id;
+  node.setSubmitMode(IOTA_SUBMIT_NODE_PARENTS);
+  node.setLocalPow(true);
+  TEST_ASSERT_EQUAL_INT(0, node.sendIndexation("iota_test", data, msg_id));
+  printf("node parents: %lu bytes sent\n", node.httpStats().tx_bytes);
+  TEST_ASSERT(node.httpStats().tx_bytes > 2 * data.length());
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_local_pow(const size_t call_count) {
+  const uint32_t scores[] = {10, 100};
+  const uint64_t exp_nonces[] = {650, 15923}; // the lowest ones
+  uint8_t msg[64] = {};
+  powEngine pow(1);
+
+  for (size_t s = 0; s < 2; s++) {
+    // bytes 0 to 55 and the nonce field
+    for (size_t i = 0; i < sizeof(msg); i++) {
+      msg[i] = i < sizeof(msg) - POW_NONCE_BYTES ? i : 0;
+    }
+    Timer t;
+    t.start();
+    TEST_ASSERT_EQUAL_INT(0, pow.solve(msg, sizeof(msg), scores[s]));
+    t.stop();
+    TEST_ASSERT_EQUAL_UINT64(exp_nonces[s], pow.nonce());
+    TEST_ASSERT(pow.trailingZeros(msg, sizeof(msg)) >=
+                powEngine::targetZeros(sizeof(msg), scores[s]));
+    auto us = t.elapsed_time().count();
+    printf("score %lu: %llu hashes in %lld ms, %llu hashes/s\n", scores[s],
+           pow.hashes(), us / 1000, pow.hashes() * 1000000 / (us + 1));
+  }
+
+  // sliced search finds the same nonce, the nonce field is not hashed
+  TEST_ASSERT_EQUAL_INT(0, pow.prepare(msg, sizeof(msg), scores[0]));
+  int ret = 0;
+  while ((ret = pow.search(4)) == 0) {
+  }
+  TEST_ASSERT_EQUAL_INT(1, ret);
+  TEST_ASSERT_EQUAL_UINT64(exp_nonces[0], pow.nonce());
+  TEST_ASSERT_EQUAL_INT(0, pow.prepare(msg, sizeof(msg), scores[1]));
+  pow.cancel();
+  TEST_ASSERT_EQUAL_INT(-1, pow.search(1));
+  return CaseNext;
+}
+
+static void indexation_done(async_result_t *res, int ret) {
+  res->ret = ret;
+  res->done.release();
+}
+
+static control_t test_async_local_pow(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  EventQueue queue;
+  Thread thread(osPriorityNormal, HTTP_THREAD_STACK_SIZE);
+  thread.start(callback(&queue, &EventQueue::dispatch_forever));
+  iotaAPI iota;
+  async_result_t res = {};
+  iota.setSubmitMode(IOTA_SUBMIT_TIPS);
+  iota.setLocalPow(true);
+  // refreshes come due many times during the PoW
+  iota.setTipsRefreshInterval(100);
+  iota.setEventQueue(&queue);
+
+  Timer t;
+  t.start();
+  TEST_ASSERT_EQUAL_INT(0, iota.sendIndexationAsync(
+                               "iota_test", "pow",
+                               callback(indexation_done, &res)));
+  TEST_ASSERT(res.done.try_acquire_for(300s));
+  t.stop();
+  printf("async local PoW message in %lld ms\n",
+         t.elapsed_time().count() / 1000);
+  // the refresh kept off the client, the solved message was posted
+  TEST_ASSERT_EQUAL_INT(0, res.ret);
+  TEST_ASSERT(t.elapsed_time() > 100ms);
+
+  iota.setEventQueue(NULL);
+  queue.break_dispatch();
+  thread.join();
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_batch_publisher(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  EventQueue queue;
+  Thread thread(osPriorityNormal, HTTP_THREAD_STACK_SIZE);
+  thread.start(callback(&queue, &EventQueue::dispatch_forever));
+  iotaAPI iota;
+  iota.setEventQueue(&queue);
+
+  {
+    batchPublisher publisher(iota, &queue, "iota_test", "test-sensor",
+                             {"temp", "humi"});
+    float values[] = {21.5, 40.25};
+    // a full batch goes out as one message, the rest on close
+    for (int i = 0; i < BATCH_SAMPLES + 1; i++) {
+      TEST_ASSERT_EQUAL_INT(0, publisher.add(1614500719 + i, values));
+    }
+    // two messages take a few seconds on a responsive node
+    TEST_ASSERT_EQUAL_INT(0, publisher.close(15000));
+    TEST_ASSERT_EQUAL_UINT32(2, publisher.stats().batches);
+    TEST_ASSERT_EQUAL_UINT32(BATCH_SAMPLES + 1, publisher.stats().samples);
+    TEST_ASSERT_EQUAL_UINT32(0, publisher.stats().failed);
+    printf("batch fill %u%%, %lu bytes\n", publisher.fillRatio(),
+           publisher.stats().bytes);
+  }
+
+  iota.setEventQueue(NULL);
+  queue.break_dispatch();
+  thread.join();
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static control_t test_tls_session_resume(const size_t call_count) {
+  WiFiInterface *wifi = WiFiInterface::get_default_instance();
+  TEST_ASSERT_NOT_NULL(wifi);
+  nsapi_error_t net_err = wifi->connect(WIFI_SSID, WIFI_PWD, WIFI_SECURITY);
+  TEST_ASSERT(net_err == NSAPI_ERROR_OK);
+
+  httpClient client;
+  client.set_keep_alive(false);
+  TEST_ASSERT(client.get("/api/v1/info") > 0);
+  // a new client reconnects with the session of the first one
+  httpClient client2;
+  client2.set_keep_alive(false);
+  TEST_ASSERT(client2.get("/api/v1/info") > 0);
+  printf("handshakes %u, resumed %u\n", client2.stats().handshakes,
+         client2.stats().resumed);
+#if TLS_SESSION_RESUME
+  TEST_ASSERT_EQUAL_UINT32(1, client2.stats().resumed);
+#else
+  TEST_ASSERT_EQUAL_UINT32(0, client2.stats().resumed);
+#endif
+  wifi->disconnect();
+  return CaseNext;
+}
+
+static uint64_t stub_now = 1;
+static int stub_error = 0;
+static int stub_queries = 0;
+
+static uint64_t stub_clock() { return stub_now; }
+
+static int stub_resolver(void *ctx, const char *host, char *addr,
+                         size_t addr_len) {
+  stub_queries++;
+  if (stub_error) {
+    return stub_error;
+  }
+  snprintf(addr, addr_len, "10.0.0.%d", stub_queries);
+  return 0;
+}
+
+static control_t test_dns_cache(const size_t call_count) {
+  char addr[DNS_ADDR_LEN] = {};
+  dnsCache dns(stub_resolver, NULL, stub_clock, 1000, 100);
+
+  // fresh entries skip the resolver
+  TEST_ASSERT(dns.lookup("node", addr, sizeof(addr)) == 0);
+  TEST_ASSERT_EQUAL_STRING("10.0.0.1", addr);
+  TEST_ASSERT(dns.lookup("node", addr, sizeof(addr)) == 0);
+  TEST_ASSERT_EQUAL_INT(1, stub_queries);
+  TEST_ASSERT_EQUAL_UINT32(1, dns.stats().hits);
+
+  // expired entry and failing resolver, the last known good address is used
+  stub_now += 1001;
+  stub_error = NSAPI_ERROR_DNS_FAILURE;
+  TEST_ASSERT(dns.lookup("node", addr, sizeof(addr)) == 0);
+  TEST_ASSERT_EQUAL_STRING("10.0.0.1", addr);
+  TEST_ASSERT_EQUAL_INT(2, stub_queries);
+
+  // failures are cached
+  TEST_ASSERT(dns.lookup("other", addr, sizeof(addr)) ==
+              NSAPI_ERROR_DNS_FAILURE);
+  TEST_ASSERT(dns.lookup("other", addr, sizeof(addr)) ==
+              NSAPI_ERROR_DNS_FAILURE);
+  TEST_ASSERT_EQUAL_INT(3, stub_queries);
+  TEST_ASSERT_EQUAL_UINT32(1, dns.stats().negative_hits);
+
+  // retried after the negative TTL
+  stub_now += 101;
+  stub_error = 0;
+  TEST_ASSERT(dns.lookup("other", addr, sizeof(addr)) == 0);
+  TEST_ASSERT_EQUAL_STRING("10.0.0.4", addr);
+  return CaseNext;
+}
+
+static control_t test_node_pool(const size_t call_count) {
+  nodePool pool(stub_clock, 1000, 5000);
+  TEST_ASSERT_EQUAL_INT(3,
+                        pool.add_list("a.node:443, b.node,c.node:8443", 443));
+  TEST_ASSERT_EQUAL_UINT16(443, pool.node(1).port);
+  TEST_ASSERT_EQUAL_UINT16(8443, pool.node(2).port);
+  TEST_ASSERT_EQUAL_INT(-1, pool.add_list("d.node:abc", 443));
+
+  // every node is measured once, then the fastest one is used
+  TEST_ASSERT_EQUAL_INT(0, pool.select());
+  pool.report(0, true, 300);
+  TEST_ASSERT_EQUAL_INT(1, pool.select());
+  pool.report(1, true, 100);
+  TEST_ASSERT_EQUAL_INT(2, pool.select());
+  pool.report(2, true, 200);
+  TEST_ASSERT_EQUAL_INT(1, pool.select());
+
+  // repeated failures move the requests to the next fastest node
+  pool.report(1, false, -1);
+  TEST_ASSERT_EQUAL_INT(1, pool.select());
+  pool.report(1, false, -1);
+  TEST_ASSERT_EQUAL_INT(2, pool.select());
+
+  // back after the cooldown, but slower now
+  stub_now += 1000;
+  TEST_ASSERT_EQUAL_INT(1, pool.select());
+  for (int i = 0; i < 8; i++) {
+    pool.report(1, true, 1000);
+  }
+  TEST_ASSERT_EQUAL_INT(2, pool.select());
+
+  // outdated estimates are measured again
+  stub_now += 5000;
+  TEST_ASSERT_EQUAL_INT(0, pool.select());
+  return CaseNext;
+}
+
 // BLAKE2 hash function
 // test vectors: https://github.com/BLAKE2/BLAKE2/tree/master/testvectors
 static control_t test_blake2b_hash(const size_t call_count) {
@@ -55,6 +827,441 @@ static control_t test_blake2b_hash(const size_t call_count) {
   return CaseNext;
 }
 
+// every compression backend against the test vectors, then its speed
+static control_t test_blake2b_backends(const size_t call_count) {
+  const size_t bench_len = 16 * 1024;
+  const int rounds = 16;
+  uint8_t msg[256] = {};
+  uint8_t out[64] = {};
+  uint8_t *bench = new uint8_t[bench_len];
+  TEST_ASSERT_NOT_NULL(bench);
+
+  for (size_t i = 0; i < sizeof(msg); i++) {
+    msg[i] = i;
+  }
+  for (size_t i = 0; i < bench_len; i++) {
+    bench[i] = i * 131 + 7;
+  }
+
+  const blake2b_backend *selected = blake2b_get_backend();
+  size_t count = 0;
+  const blake2b_backend *backends = blake2b_backends(&count);
+  TEST_ASSERT(count > 0);
+  printf("default backend: %s\n", selected->name);
+  for (size_t b = 0; b < count; b++) {
+    TEST_ASSERT_EQUAL_INT(0, blake2b_set_backend(backends[b].name));
+    for (size_t i = 0; i < sizeof(msg); i++) {
+      TEST_ASSERT_EQUAL_INT(0, blake2b(out, 32, msg, i, NULL, 0));
+      TEST_ASSERT_EQUAL_MEMORY(blake2b_256[i], out, 32);
+      TEST_ASSERT_EQUAL_INT(0, blake2b(out, 64, msg, i, NULL, 0));
+      TEST_ASSERT_EQUAL_MEMORY(blake2b_512[i], out, 64);
+    }
+
+    Timer t;
+    t.start();
+    for (int i = 0; i < rounds; i++) {
+      blake2b(out, 32, bench, bench_len, NULL, 0);
+    }
+    t.stop();
+    auto us = t.elapsed_time().count();
+    // core cycles per input byte
+    uint64_t cpb_x100 = (uint64_t)us * (SystemCoreClock / 10000) /
+                        ((uint64_t)bench_len * rounds);
+    printf("%-8s %lld us per %d x %u B, %llu.%02llu cycles/byte\n",
+           backends[b].name, us, rounds, bench_len, cpb_x100 / 100,
+           cpb_x100 % 100);
+  }
+  TEST_ASSERT_EQUAL_INT(-1, blake2b_set_backend("none"));
+  TEST_ASSERT_EQUAL_INT(0, blake2b_set_backend(selected->name));
+
+  delete[] bench;
+  return CaseNext;
+}
+
+// batched message IDs against one hash at a time
+static control_t test_blake2b_many(const size_t call_count) {
+  const size_t count = 64;
+  const size_t msg_len = 200;
+  uint8_t *msgs = new uint8_t[count * msg_len];
+  uint8_t *ids = new uint8_t[count * IOTA_MESSAGE_ID_BYTES];
+  uint8_t const *ptrs[count];
+  size_t lens[count];
+  uint8_t id[IOTA_MESSAGE_ID_BYTES] = {};
+  TEST_ASSERT(msgs && ids);
+
+  for (size_t i = 0; i < count * msg_len; i++) {
+    msgs[i] = i * 131 + 7;
+  }
+  for (size_t i = 0; i < count; i++) {
+    ptrs[i] = msgs + i * msg_len;
+    lens[i] = msg_len - i; // lanes finish at different blocks
+  }
+
+  const size_t default_lanes = blake2b_many_lanes();
+  const size_t widths[] = {1, 4, 8};
+  for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+    if (blake2b_many_set_lanes(widths[w]) != 0) {
+      continue;
+    }
+    memset(ids, 0, count * IOTA_MESSAGE_ID_BYTES);
+    TEST_ASSERT_EQUAL_INT(0, iota_message_ids(ptrs, lens, count, ids));
+    for (size_t i = 0; i < count; i++) {
+      blake2b(id, sizeof(id), ptrs[i], lens[i], NULL, 0);
+      TEST_ASSERT_EQUAL_MEMORY(id, ids + i * IOTA_MESSAGE_ID_BYTES,
+                               sizeof(id));
+    }
+
+    Timer t;
+    t.start();
+    iota_message_ids(ptrs, lens, count, ids);
+    t.stop();
+    printf("%u lanes: %lld us per %u IDs\n", widths[w],
+           t.elapsed_time().count(), count);
+  }
+  TEST_ASSERT_EQUAL_INT(-1, blake2b_many_set_lanes(2));
+  TEST_ASSERT_EQUAL_INT(0, blake2b_many_set_lanes(default_lanes));
+
+  // an output length out of range fails the whole batch
+  blake2b_job job = {id, 0, msgs, msg_len, NULL};
+  TEST_ASSERT_EQUAL_INT(-1, blake2b_many(&job, 1));
+
+  delete[] msgs;
+  delete[] ids;
+  return CaseNext;
+}
+
+// BLAKE2bp tree hashing and BLAKE2Xb extendable output
+static control_t test_blake2x(const size_t call_count) {
+  const size_t max_len = 2049;
+  uint8_t key[BLAKE2B_KEYBYTES] = {};
+  uint8_t out[256] = {};
+  uint8_t *in = new uint8_t[max_len];
+  TEST_ASSERT_NOT_NULL(in);
+
+  for (size_t i = 0; i < sizeof(key); i++) {
+    key[i] = i;
+  }
+  for (size_t i = 0; i < max_len; i++) {
+    in[i] = i;
+  }
+
+  for (size_t v = 0; v < sizeof(blake2bp_keyed_lens) / sizeof(size_t); v++) {
+    size_t len = blake2bp_keyed_lens[v];
+    TEST_ASSERT_EQUAL_INT(
+        0, blake2bp(out, 64, in, len, key, sizeof(key)));
+    TEST_ASSERT_EQUAL_MEMORY(blake2bp_keyed[v], out, 64);
+
+    // the same digest fed in uneven pieces
+    blake2bp_state S;
+    TEST_ASSERT_EQUAL_INT(0, blake2bp_init_key(&S, 64, key, sizeof(key)));
+    for (size_t pos = 0, step = 1; pos < len; pos += step, step = step * 3 + 1) {
+      blake2bp_update(&S, in + pos, step < len - pos ? step : len - pos);
+    }
+    TEST_ASSERT_EQUAL_INT(0, blake2bp_final(&S, out, 64));
+    TEST_ASSERT_EQUAL_MEMORY(blake2bp_keyed[v], out, 64);
+  }
+
+  for (size_t v = 0; v < sizeof(blake2xb_keyed) / sizeof(blake2xb_keyed[0]);
+       v++) {
+    size_t len = blake2xb_keyed[v].len;
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(0,
+                          blake2xb(out, len, in, 256, key, sizeof(key)));
+    TEST_ASSERT_EQUAL_MEMORY(blake2xb_keyed[v].out, out, len);
+  }
+  // the output length is fixed at init
+  blake2xb_state X;
+  TEST_ASSERT_EQUAL_INT(0, blake2xb_init(&X, 64));
+  TEST_ASSERT_EQUAL_INT(-1, blake2xb_final(&X, out, 32));
+
+  // large payload digest, sequential against tree hashing
+  const size_t bench_len = 16 * 1024;
+  uint8_t *bench = new uint8_t[bench_len];
+  TEST_ASSERT_NOT_NULL(bench);
+  memset(bench, 0xa5, bench_len);
+  Timer t;
+  t.start();
+  blake2b(out, 32, bench, bench_len, NULL, 0);
+  auto seq_us = t.elapsed_time().count();
+  t.reset();
+  blake2bp(out, 32, bench, bench_len, NULL, 0);
+  auto tree_us = t.elapsed_time().count();
+  t.stop();
+  printf("%u B: blake2b %lld us, blake2bp %lld us (%u lanes)\n", bench_len,
+         seq_us, tree_us, blake2b_many_lanes());
+
+  delete[] bench;
+  delete[] in;
+  return CaseNext;
+}
+
+// ed25519 on the selected field backend, then its speed
+// test vector: https://tools.ietf.org/html/rfc8032#section-7.1 test 2
+static control_t test_ed25519(const size_t call_count) {
+  const int rounds = 8;
+  const uint8_t sk[32] = {
+      0x4c, 0xcd, 0x08, 0x9b, 0x28, 0xff, 0x96, 0xda,
+      0x9d, 0xb6, 0xc3, 0x46, 0xec, 0x11, 0x4e, 0x0f,
+      0x5b, 0x8a, 0x31, 0x9f, 0x35, 0xab, 0xa6, 0x24,
+      0xda, 0x8c, 0xf6, 0xed, 0x4f, 0xb8, 0xa6, 0xfb};
+  const uint8_t exp_pk[32] = {
+      0x3d, 0x40, 0x17, 0xc3, 0xe8, 0x43, 0x89, 0x5a,
+      0x92, 0xb7, 0x0a, 0xa7, 0x4d, 0x1b, 0x7e, 0xbc,
+      0x9c, 0x98, 0x2c, 0xcf, 0x2e, 0xc4, 0x96, 0x8c,
+      0xc0, 0xcd, 0x55, 0xf1, 0x2a, 0xf4, 0x66, 0x0c};
+  const uint8_t exp_sig[64] = {
+      0x92, 0xa0, 0x09, 0xa9, 0xf0, 0xd4, 0xca, 0xb8,
+      0x72, 0x0e, 0x82, 0x0b, 0x5f, 0x64, 0x25, 0x40,
+      0xa2, 0xb2, 0x7b, 0x54, 0x16, 0x50, 0x3f, 0x8f,
+      0xb3, 0x76, 0x22, 0x23, 0xeb, 0xdb, 0x69, 0xda,
+      0x08, 0x5a, 0xc1, 0xe4, 0x3e, 0x15, 0x99, 0x6e,
+      0x45, 0x8f, 0x36, 0x13, 0xd0, 0xf1, 0x1d, 0x8c,
+      0x38, 0x7b, 0x2e, 0xae, 0xb4, 0x30, 0x2a, 0xee,
+      0xb0, 0x0d, 0x29, 0x16, 0x12, 0xbb, 0x0c, 0x00};
+  const uint8_t msg[] = {0x72};
+  uint8_t pk[32] = {};
+  uint8_t sig[64] = {};
+
+  ed25519_publickey(sk, pk);
+  TEST_ASSERT_EQUAL_MEMORY(exp_pk, pk, sizeof(exp_pk));
+  ed25519_sign(msg, sizeof(msg), sk, pk, sig);
+  TEST_ASSERT_EQUAL_MEMORY(exp_sig, sig, sizeof(exp_sig));
+  TEST_ASSERT_EQUAL_INT(0, ed25519_sign_open(msg, sizeof(msg), pk, sig));
+  sig[5] ^= 0x10;
+  TEST_ASSERT_EQUAL_INT(-1, ed25519_sign_open(msg, sizeof(msg), pk, sig));
+  sig[5] ^= 0x10;
+
+  Timer t;
+  t.start();
+  for (int i = 0; i < rounds; i++) {
+    ed25519_sign(msg, sizeof(msg), sk, pk, sig);
+  }
+  t.stop();
+  auto sign_us = t.elapsed_time().count() / rounds;
+
+  t.reset();
+  t.start();
+  for (int i = 0; i < rounds; i++) {
+    TEST_ASSERT_EQUAL_INT(0, ed25519_sign_open(msg, sizeof(msg), pk, sig));
+  }
+  t.stop();
+  auto verify_us = t.elapsed_time().count() / rounds;
+
+  // thousands of core cycles per operation
+  printf("ed25519 sign %lld us, %llu kcycles\n", sign_us,
+         (uint64_t)sign_us * (SystemCoreClock / 1000000) / 1000);
+  printf("ed25519 verify %lld us, %llu kcycles\n", verify_us,
+         (uint64_t)verify_us * (SystemCoreClock / 1000000) / 1000);
+  return CaseNext;
+}
+
+// signing with expanded and cached keys against ed25519_sign, then the
+// signatures per second of each
+static control_t test_ed25519_expanded(const size_t call_count) {
+  const size_t keys = ED25519_SIGN_CACHE_KEYS + 1;
+  const int rounds = 16;
+  uint8_t sk[keys][32] = {};
+  uint8_t pk[keys][32] = {};
+  uint8_t msg[64] = {};
+  uint8_t exp_sig[64] = {};
+  uint8_t sig[64] = {};
+  ed25519_expanded_key key;
+  ed25519_sign_cache *cache = new ed25519_sign_cache;
+  TEST_ASSERT_NOT_NULL(cache);
+
+  for (size_t k = 0; k < keys; k++) {
+    for (size_t i = 0; i < 32; i++) {
+      sk[k][i] = k * 32 + i + 1;
+    }
+    ed25519_publickey(sk[k], pk[k]);
+  }
+
+  ed25519_sign_cache_init(cache);
+  // more keys than slots, so some are evicted and expanded again
+  for (int r = 0; r < rounds; r++) {
+    size_t k = (r * 3) % keys;
+    msg[0] = r;
+    ed25519_sign(msg, sizeof(msg), sk[k], pk[k], exp_sig);
+    ed25519_expand_key(sk[k], &key);
+    TEST_ASSERT_EQUAL_MEMORY(pk[k], key.pk, 32);
+    ed25519_sign_expanded(msg, sizeof(msg), &key, sig);
+    TEST_ASSERT_EQUAL_MEMORY(exp_sig, sig, sizeof(sig));
+    TEST_ASSERT_EQUAL_INT(
+        0, ed25519_sign_cached(cache, msg, sizeof(msg), sk[k], pk[k], sig));
+    TEST_ASSERT_EQUAL_MEMORY(exp_sig, sig, sizeof(sig));
+  }
+  // a secret key that does not belong to the public key
+  TEST_ASSERT_EQUAL_INT(
+      -1, ed25519_sign_cached(cache, msg, sizeof(msg), sk[1], pk[0], sig));
+
+  Timer t;
+  t.start();
+  for (int r = 0; r < rounds; r++) {
+    ed25519_sign(msg, sizeof(msg), sk[0], pk[0], sig);
+  }
+  auto sign_us = t.elapsed_time().count();
+  t.reset();
+  for (int r = 0; r < rounds; r++) {
+    ed25519_sign_expanded(msg, sizeof(msg), &key, sig);
+  }
+  auto expanded_us = t.elapsed_time().count();
+  t.reset();
+  for (int r = 0; r < rounds; r++) {
+    ed25519_sign_cached(cache, msg, sizeof(msg), sk[r % 2], pk[r % 2], sig);
+  }
+  auto cached_us = t.elapsed_time().count();
+  t.stop();
+  printf("ed25519 sign %lld, expanded %lld, cached %lld signatures/s\n",
+         sign_us ? rounds * 1000000LL / sign_us : 0,
+         expanded_us ? rounds * 1000000LL / expanded_us : 0,
+         cached_us ? rounds * 1000000LL / cached_us : 0);
+
+  ed25519_sign_cache_clear(cache);
+  memset(&key, 0, sizeof(key));
+  delete cache;
+  return CaseNext;
+}
+
+typedef struct {
+  const uint8_t **m;
+  size_t *lens;
+  const uint8_t **pks;
+  const uint8_t **rs;
+  size_t num;
+  int *valid;
+  size_t rounds;
+  int ret;
+  uint64_t us;
+} batch_job_t;
+
+static void batch_job_run(batch_job_t *job) {
+  Timer t;
+  t.start();
+  for (size_t r = 0; r < job->rounds; r++) {
+    job->ret = ed25519_sign_open_batch(job->m, job->lens, job->pks, job->rs,
+                                       job->num, job->valid);
+  }
+  t.stop();
+  job->us = t.elapsed_time().count();
+}
+
+// the batch does not fit on the main thread stack
+static int batch_verify(batch_job_t *job, size_t num, size_t rounds) {
+  Thread thread(osPriorityNormal, ED25519_BATCH_STACK_SIZE);
+  job->num = num;
+  job->rounds = rounds;
+  job->ret = -1;
+  TEST_ASSERT_EQUAL_INT(osOK, thread.start(callback(batch_job_run, job)));
+  thread.join();
+  return job->ret;
+}
+
+// batch verification on every field backend the CPU supports, then
+// verifications per second by batch size
+static control_t test_ed25519_batch(const size_t call_count) {
+  const size_t count = ED25519_BATCH_BENCH_MAX;
+  const size_t keys = 4;
+  const size_t msg_len = 32;
+  const char *backends[] = {"ref", "avx2", "avx512ifma"};
+  uint8_t sk[keys][32] = {};
+  uint8_t pk[keys][32] = {};
+  uint8_t *msgs = new uint8_t[count * msg_len];
+  uint8_t *sigs = new uint8_t[count * 64];
+  const uint8_t **m = new const uint8_t *[count];
+  const uint8_t **pks = new const uint8_t *[count];
+  const uint8_t **rs = new const uint8_t *[count];
+  size_t *lens = new size_t[count];
+  int *valid = new int[count];
+  TEST_ASSERT(msgs && sigs && m && pks && rs && lens && valid);
+
+  for (size_t k = 0; k < keys; k++) {
+    for (size_t i = 0; i < 32; i++) {
+      sk[k][i] = k * 32 + i;
+    }
+    ed25519_publickey(sk[k], pk[k]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < msg_len; j++) {
+      msgs[i * msg_len + j] = i * 7 + j;
+    }
+    m[i] = msgs + i * msg_len;
+    lens[i] = msg_len;
+    pks[i] = pk[i % keys];
+    rs[i] = sigs + i * 64;
+    ed25519_sign(m[i], lens[i], sk[i % keys], pk[i % keys], sigs + i * 64);
+  }
+  batch_job_t job = {m, lens, pks, rs, 0, valid, 0, 0, 0};
+
+  const char *default_backend = ed25519_batch_get_backend();
+  for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+    if (ed25519_batch_set_backend(backends[b]) != 0) {
+      printf("%s: not supported\n", backends[b]);
+      continue;
+    }
+    TEST_ASSERT_EQUAL_INT(0, batch_verify(&job, count, 1));
+    // one bad signature fails the batch and only itself
+    sigs[(count / 2) * 64 + 40] ^= 0x04;
+    TEST_ASSERT_NOT_EQUAL(0, batch_verify(&job, count, 1));
+    sigs[(count / 2) * 64 + 40] ^= 0x04;
+    for (size_t i = 0; i < count; i++) {
+      TEST_ASSERT_EQUAL_INT(i != count / 2, valid[i]);
+    }
+
+    // about count signatures per batch size
+    for (size_t n = 1; n <= count; n *= 2) {
+      size_t rounds = count / n;
+      batch_verify(&job, n, rounds);
+      uint64_t us = job.us;
+      printf("%s: batch %u, %llu verifications/s\n", backends[b], n,
+             us ? (uint64_t)n * rounds * 1000000 / us : 0);
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(-1, ed25519_batch_set_backend("sse3"));
+  TEST_ASSERT_EQUAL_INT(0, ed25519_batch_set_backend(default_backend));
+
+  delete[] msgs;
+  delete[] sigs;
+  delete[] m;
+  delete[] pks;
+  delete[] rs;
+  delete[] lens;
+  delete[] valid;
+  return CaseNext;
+}
+
+// random bytes for the batch verification scalars, then their throughput by
+// request size
+static control_t test_ed25519_randombytes(const size_t call_count) {
+  const size_t total = 64 * 1024;
+  const uint8_t zero[64] = {};
+  uint8_t a[64] = {};
+  uint8_t b[64] = {};
+
+  ed25519_randombytes_unsafe(a, sizeof(a));
+  ed25519_randombytes_unsafe(b, sizeof(b));
+  TEST_ASSERT(memcmp(a, zero, sizeof(a)) != 0);
+  TEST_ASSERT(memcmp(a, b, sizeof(a)) != 0);
+
+  // one scalar is 16 bytes, a full batch of 64 takes 1024
+  const size_t sizes[] = {16, 256, 1024};
+  uint8_t *buf = new uint8_t[1024];
+  TEST_ASSERT_NOT_NULL(buf);
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    Timer t;
+    t.start();
+    for (size_t done = 0; done < total; done += sizes[s]) {
+      ed25519_randombytes_unsafe(buf, sizes[s]);
+    }
+    t.stop();
+    uint64_t us = t.elapsed_time().count();
+    printf("%u B requests: %llu KiB/s\n", sizes[s],
+           us ? (uint64_t)total * 1000000 / 1024 / us : 0);
+  }
+
+  delete[] buf;
+  return CaseNext;
+}
+
 // HMAC-SHA-256 and HMAC-SHA-512
 // test vectors: https://tools.ietf.org/html/rfc4231#section-4.2
 static control_t test_hmacsha(const size_t call_count) {
@@ -284,19 +1491,48 @@ static control_t message_with_tx(const size_t call_count) {
 }
 
 utest::v1::status_t greentea_setup(const size_t number_of_cases) {
-  // Here, we specify the timeout (60s) and the host test (a built-in host test
-  // or the name of our Python file)
-  GREENTEA_SETUP(60, "default_auto");
+  // Here, we specify the timeout (600s) and the host test (a built-in host test
+  // or the name of our Python file). 14 cases connect to WiFi and the node,
+  // which takes up to about 40s each when a request runs into its timeout,
+  // the PoW, BLAKE2 and ed25519 benchmarks add about a minute and the
+  // asynchronous local PoW at the node's score up to five minutes
+  GREENTEA_SETUP(960, "default_auto");
 
   return greentea_test_setup_handler(number_of_cases);
 }
 
 // List of test cases in this file
 Case cases[] = {Case("HTTP Client", test_http_client),
+                Case("HTTP Keep-Alive", test_http_keep_alive),
+                Case("HTTP Body Sink", test_http_body_sink),
+                Case("HTTP Response Framing", test_http_framing),
+                Case("HTTP Pipelining", test_http_pipeline),
+                Case("HTTP Multi Connection", test_http_multi),
+                Case("HTTP Async", test_http_async),
+                Case("HTTP Request Writer", test_http_writer),
+                Case("HTTP Retry", test_http_retry),
+                Case("TLS Session Resumption", test_tls_session_resume),
+                Case("DNS Cache", test_dns_cache),
+                Case("Node Pool", test_node_pool),
+                Case("IOTA Tips Cache", test_tips_cache),
+                Case("IOTA Submit Modes", test_submit_modes),
+                Case("Hex Codec", test_hex_codec),
+                Case("IOTA JSON Writer", test_json_writer),
+                Case("IOTA Message Format", test_message_format),
+                Case("IOTA Batch Publisher", test_batch_publisher),
+                Case("IOTA Local PoW", test_local_pow),
+                Case("IOTA Async Local PoW", test_async_local_pow),
                 Case("IOTA Address", test_addr_gen),
                 Case("IOTA TX Essence", tx_essence_serialization),
                 Case("IOTA Message", message_with_tx),
                 Case("BLAKE2", test_blake2b_hash),
+                Case("BLAKE2 Backends", test_blake2b_backends),
+                Case("BLAKE2 Multi-buffer", test_blake2b_many),
+                Case("BLAKE2bp and BLAKE2Xb", test_blake2x),
+                Case("Ed25519", test_ed25519),
+                Case("Ed25519 Expanded Keys", test_ed25519_expanded),
+                Case("Ed25519 Batch Verify", test_ed25519_batch),
+                Case("Ed25519 Random Bytes", test_ed25519_randombytes),
                 Case("HMAC SHA", test_hmacsha)};
 
 Specification specification(greentea_setup, cases);
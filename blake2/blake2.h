@@ -159,10 +159,10 @@ extern "C" {
   // int blake2sp_update( blake2sp_state *S, const void *in, size_t inlen );
   // int blake2sp_final( blake2sp_state *S, void *out, size_t outlen );
 
-  // int blake2bp_init( blake2bp_state *S, size_t outlen );
-  // int blake2bp_init_key( blake2bp_state *S, size_t outlen, const void *key, size_t keylen );
-  // int blake2bp_update( blake2bp_state *S, const void *in, size_t inlen );
-  // int blake2bp_final( blake2bp_state *S, void *out, size_t outlen );
+  int blake2bp_init( blake2bp_state *S, size_t outlen );
+  int blake2bp_init_key( blake2bp_state *S, size_t outlen, const void *key, size_t keylen );
+  int blake2bp_update( blake2bp_state *S, const void *in, size_t inlen );
+  int blake2bp_final( blake2bp_state *S, void *out, size_t outlen );
 
   /* Variable output length API */
   // int blake2xs_init( blake2xs_state *S, const size_t outlen );
@@ -170,20 +170,20 @@ extern "C" {
   // int blake2xs_update( blake2xs_state *S, const void *in, size_t inlen );
   // int blake2xs_final(blake2xs_state *S, void *out, size_t outlen);
 
-  // int blake2xb_init( blake2xb_state *S, const size_t outlen );
-  // int blake2xb_init_key( blake2xb_state *S, const size_t outlen, const void *key, size_t keylen );
-  // int blake2xb_update( blake2xb_state *S, const void *in, size_t inlen );
-  // int blake2xb_final(blake2xb_state *S, void *out, size_t outlen);
+  int blake2xb_init( blake2xb_state *S, const size_t outlen );
+  int blake2xb_init_key( blake2xb_state *S, const size_t outlen, const void *key, size_t keylen );
+  int blake2xb_update( blake2xb_state *S, const void *in, size_t inlen );
+  int blake2xb_final(blake2xb_state *S, void *out, size_t outlen);
 
   /* Simple API */
   // int blake2s( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
   int blake2b( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
 
   // int blake2sp( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
-  // int blake2bp( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
+  int blake2bp( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
 
   // int blake2xs( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
-  // int blake2xb( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
+  int blake2xb( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
 
   /* This is simply an alias for blake2b */
   int blake2( void *out, size_t outlen, const void *in, size_t inlen, const void *key, size_t keylen );
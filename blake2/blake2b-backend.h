@@ -0,0 +1,42 @@
+/*
+   BLAKE2b compression backends
+
+   The compression function of blake2b-ref.c is picked from the backends
+   built for the target: SSE2, SSSE3 and AVX2 on x86, selected at run time,
+   NEON on ARM with Advanced SIMD, and an unrolled scalar version elsewhere,
+   Cortex-M included. The reference version stays available for comparison.
+*/
+#ifndef BLAKE2B_BACKEND_H
+#define BLAKE2B_BACKEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "blake2.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+  typedef void ( *blake2b_compress_fn )( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] );
+
+  typedef struct blake2b_backend__
+  {
+    const char *name;
+    blake2b_compress_fn compress;
+  } blake2b_backend;
+
+  void blake2b_compress_ref( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] );
+
+  /* The backend in use, the fastest one the CPU supports by default */
+  const blake2b_backend *blake2b_get_backend( void );
+  /* Returns -1 if there is no such backend or the CPU does not support it */
+  int blake2b_set_backend( const char *name );
+  /* The backends the CPU supports, the reference first */
+  const blake2b_backend *blake2b_backends( size_t *count );
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,384 @@
+/*
+   Multi-buffer BLAKE2b
+
+   You may use this under the terms of the CC0, the OpenSSL Licence, or the
+   Apache Public License 2.0, at your option.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2.h"
+#include "blake2-impl.h"
+#include "blake2b-mb.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BLAKE2B_MB_X86 1
+#include <immintrin.h>
+#endif
+
+#if BLAKE2B_MB_X86
+static const uint64_t blake2b_IV[8] =
+{
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] =
+{
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 } ,
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 } ,
+  { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 } ,
+  {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 } ,
+  {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 } ,
+  {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 } ,
+  { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 } ,
+  { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 } ,
+  {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 } ,
+  { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0 } ,
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 } ,
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+/*
+   The state of each input sits in one lane: word i of every input is
+   vector v[i], so G needs no diagonal shuffles and message word j of every
+   input is vector m[j].
+*/
+typedef struct blake2b_lanes__
+{
+  uint64_t h[8][BLAKE2B_MB_MAX_LANES];
+  uint64_t t[BLAKE2B_MB_MAX_LANES];
+  uint64_t f[BLAKE2B_MB_MAX_LANES];
+  const uint8_t *block[BLAKE2B_MB_MAX_LANES];
+} blake2b_lanes;
+
+#define G(r,i,a,b,c,d)                                  \
+  do {                                                  \
+    a = ADD( ADD( a, b ), m[blake2b_sigma[r][2*i+0]] ); \
+    d = ROT32( XOR( d, a ) );                           \
+    c = ADD( c, d );                                    \
+    b = ROT24( XOR( b, c ) );                           \
+    a = ADD( ADD( a, b ), m[blake2b_sigma[r][2*i+1]] ); \
+    d = ROT16( XOR( d, a ) );                           \
+    c = ADD( c, d );                                    \
+    b = ROT63( XOR( b, c ) );                           \
+  } while(0)
+
+#define ROUND(r)                    \
+  do {                              \
+    G(r,0,v[ 0],v[ 4],v[ 8],v[12]); \
+    G(r,1,v[ 1],v[ 5],v[ 9],v[13]); \
+    G(r,2,v[ 2],v[ 6],v[10],v[14]); \
+    G(r,3,v[ 3],v[ 7],v[11],v[15]); \
+    G(r,4,v[ 0],v[ 5],v[10],v[15]); \
+    G(r,5,v[ 1],v[ 6],v[11],v[12]); \
+    G(r,6,v[ 2],v[ 7],v[ 8],v[13]); \
+    G(r,7,v[ 3],v[ 4],v[ 9],v[14]); \
+  } while(0)
+
+#define ROUNDS()  \
+  do {            \
+    ROUND( 0 );   \
+    ROUND( 1 );   \
+    ROUND( 2 );   \
+    ROUND( 3 );   \
+    ROUND( 4 );   \
+    ROUND( 5 );   \
+    ROUND( 6 );   \
+    ROUND( 7 );   \
+    ROUND( 8 );   \
+    ROUND( 9 );   \
+    ROUND( 10 );  \
+    ROUND( 11 );  \
+  } while(0)
+
+#define ADD(a,b) _mm256_add_epi64( a, b )
+#define XOR(a,b) _mm256_xor_si256( a, b )
+#define ROT32(x) _mm256_shuffle_epi32( x, _MM_SHUFFLE(2,3,0,1) )
+#define ROT24(x) _mm256_shuffle_epi8( x, r24 )
+#define ROT16(x) _mm256_shuffle_epi8( x, r16 )
+#define ROT63(x) _mm256_xor_si256( _mm256_srli_epi64( x, 63 ), _mm256_add_epi64( x, x ) )
+
+__attribute__((target("avx2")))
+static void blake2b_compress_x4( blake2b_lanes *L )
+{
+  const __m256i r16 = _mm256_setr_epi8( 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                        2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9 );
+  const __m256i r24 = _mm256_setr_epi8( 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                        3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10 );
+  __m256i m[16];
+  __m256i v[16];
+  size_t i;
+
+  /* transpose 4 words of each block at a time */
+  for( i = 0; i < 16; i += 4 ) {
+    const __m256i r0 = _mm256_loadu_si256( (const __m256i *)( L->block[0] + i * 8 ) );
+    const __m256i r1 = _mm256_loadu_si256( (const __m256i *)( L->block[1] + i * 8 ) );
+    const __m256i r2 = _mm256_loadu_si256( (const __m256i *)( L->block[2] + i * 8 ) );
+    const __m256i r3 = _mm256_loadu_si256( (const __m256i *)( L->block[3] + i * 8 ) );
+    const __m256i t0 = _mm256_unpacklo_epi64( r0, r1 );
+    const __m256i t1 = _mm256_unpackhi_epi64( r0, r1 );
+    const __m256i t2 = _mm256_unpacklo_epi64( r2, r3 );
+    const __m256i t3 = _mm256_unpackhi_epi64( r2, r3 );
+    m[i + 0] = _mm256_permute2x128_si256( t0, t2, 0x20 );
+    m[i + 1] = _mm256_permute2x128_si256( t1, t3, 0x20 );
+    m[i + 2] = _mm256_permute2x128_si256( t0, t2, 0x31 );
+    m[i + 3] = _mm256_permute2x128_si256( t1, t3, 0x31 );
+  }
+
+  for( i = 0; i < 8; ++i ) {
+    v[i] = _mm256_loadu_si256( (const __m256i *)L->h[i] );
+    v[i + 8] = _mm256_set1_epi64x( (int64_t)blake2b_IV[i] );
+  }
+  v[12] = _mm256_xor_si256( v[12], _mm256_loadu_si256( (const __m256i *)L->t ) );
+  v[14] = _mm256_xor_si256( v[14], _mm256_loadu_si256( (const __m256i *)L->f ) );
+
+  ROUNDS();
+
+  for( i = 0; i < 8; ++i ) {
+    const __m256i h = _mm256_loadu_si256( (const __m256i *)L->h[i] );
+    _mm256_storeu_si256( (__m256i *)L->h[i], _mm256_xor_si256( h, _mm256_xor_si256( v[i], v[i + 8] ) ) );
+  }
+}
+
+#undef ADD
+#undef XOR
+#undef ROT32
+#undef ROT24
+#undef ROT16
+#undef ROT63
+
+#define ADD(a,b) _mm512_add_epi64( a, b )
+#define XOR(a,b) _mm512_xor_si512( a, b )
+#define ROT32(x) _mm512_ror_epi64( x, 32 )
+#define ROT24(x) _mm512_ror_epi64( x, 24 )
+#define ROT16(x) _mm512_ror_epi64( x, 16 )
+#define ROT63(x) _mm512_ror_epi64( x, 63 )
+
+__attribute__((target("avx512f")))
+static void blake2b_compress_x8( blake2b_lanes *L )
+{
+  __m512i m[16];
+  __m512i v[16];
+  const __m512i addr = _mm512_loadu_si512( (const void *)L->block );
+  size_t i;
+
+  /* the block pointers are the gather indices */
+  for( i = 0; i < 16; ++i ) {
+    m[i] = _mm512_i64gather_epi64( _mm512_add_epi64( addr, _mm512_set1_epi64( (int64_t)( i * 8 ) ) ),
+                                   NULL, 1 );
+  }
+
+  for( i = 0; i < 8; ++i ) {
+    v[i] = _mm512_loadu_si512( (const void *)L->h[i] );
+    v[i + 8] = _mm512_set1_epi64( (int64_t)blake2b_IV[i] );
+  }
+  v[12] = _mm512_xor_si512( v[12], _mm512_loadu_si512( (const void *)L->t ) );
+  v[14] = _mm512_xor_si512( v[14], _mm512_loadu_si512( (const void *)L->f ) );
+
+  ROUNDS();
+
+  for( i = 0; i < 8; ++i ) {
+    const __m512i h = _mm512_loadu_si512( (const void *)L->h[i] );
+    _mm512_storeu_si512( (void *)L->h[i], _mm512_xor_si512( h, _mm512_xor_si512( v[i], v[i + 8] ) ) );
+  }
+}
+
+#undef ADD
+#undef XOR
+#undef ROT32
+#undef ROT24
+#undef ROT16
+#undef ROT63
+#undef G
+#undef ROUND
+#undef ROUNDS
+
+/* Hashes up to lanes jobs, each lane until its input runs out */
+static void blake2b_many_lanes_run( blake2b_job *jobs, size_t count, size_t lanes,
+                                    void ( *compress )( blake2b_lanes * ) )
+{
+  static const uint8_t zero[BLAKE2B_BLOCKBYTES] = { 0 };
+  uint8_t pad[BLAKE2B_MB_MAX_LANES][BLAKE2B_BLOCKBYTES];
+  size_t pos[BLAKE2B_MB_MAX_LANES];
+  blake2b_lanes L;
+  size_t i, j, left = count;
+
+  memset( &L, 0, sizeof( L ) );
+  for( j = 0; j < lanes; ++j ) {
+    for( i = 0; i < 8; ++i ) {
+      L.h[i][j] = blake2b_IV[i];
+    }
+    L.block[j] = zero;
+    pos[j] = 0;
+    if( j < count && jobs[j].param != NULL ) {
+      const uint8_t *p = (const uint8_t *)jobs[j].param;
+      for( i = 0; i < 8; ++i ) {
+        L.h[i][j] ^= load64( p + sizeof( L.h[i][j] ) * i );
+      }
+    } else if( j < count ) {
+      L.h[0][j] ^= 0x01010000ULL ^ jobs[j].outlen;
+    }
+  }
+
+  while( left > 0 ) {
+    for( j = 0; j < count; ++j ) {
+      const uint8_t *in = (const uint8_t *)jobs[j].in;
+      size_t rest;
+
+      if( L.f[j] != 0 ) {
+        /* finished, keeps hashing zeros */
+        L.block[j] = zero;
+        continue;
+      }
+      rest = jobs[j].inlen - pos[j];
+      if( rest > BLAKE2B_BLOCKBYTES ) {
+        L.block[j] = in + pos[j];
+        pos[j] += BLAKE2B_BLOCKBYTES;
+      } else {
+        memset( pad[j], 0, sizeof( pad[j] ) );
+        if( rest > 0 ) {
+          memcpy( pad[j], in + pos[j], rest );
+        }
+        L.block[j] = pad[j];
+        pos[j] += rest;
+        L.f[j] = (uint64_t)-1;
+      }
+      L.t[j] = pos[j];
+    }
+
+    compress( &L );
+
+    for( j = 0; j < count; ++j ) {
+      if( L.f[j] != 0 && L.block[j] == pad[j] ) {
+        uint8_t buffer[BLAKE2B_OUTBYTES];
+        for( i = 0; i < 8; ++i ) {
+          store64( buffer + sizeof( L.h[i][j] ) * i, L.h[i][j] );
+        }
+        memcpy( jobs[j].out, buffer, jobs[j].outlen );
+        --left;
+      }
+    }
+  }
+}
+
+int blake2b_many_stripes( blake2b_state *S[4], const uint8_t *in, size_t stripes )
+{
+  blake2b_lanes L;
+  size_t i, j, k;
+
+  if( blake2b_many_lanes() < 4 )
+    return -1;
+  /* the lanes have no high counter word */
+  if( S[0]->t[1] != 0 || S[0]->t[0] > UINT64_MAX - (uint64_t)stripes * BLAKE2B_BLOCKBYTES )
+    return -1;
+
+  memset( &L, 0, sizeof( L ) );
+  for( j = 0; j < 4; ++j ) {
+    for( i = 0; i < 8; ++i ) {
+      L.h[i][j] = S[j]->h[i];
+    }
+  }
+  /* the leaves of a stripe always have the same counter */
+  for( k = 0; k < stripes; ++k ) {
+    const uint64_t t = S[0]->t[0] + ( k + 1 ) * BLAKE2B_BLOCKBYTES;
+    for( j = 0; j < 4; ++j ) {
+      L.block[j] = in + ( k * 4 + j ) * BLAKE2B_BLOCKBYTES;
+      L.t[j] = t;
+    }
+    blake2b_compress_x4( &L );
+  }
+  for( j = 0; j < 4; ++j ) {
+    for( i = 0; i < 8; ++i ) {
+      S[j]->h[i] = L.h[i][j];
+    }
+    S[j]->t[0] += stripes * BLAKE2B_BLOCKBYTES;
+  }
+  return 0;
+}
+#endif
+
+static size_t blake2b_many_supported( void )
+{
+#if BLAKE2B_MB_X86
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports( "avx512f" ) )
+    return 8;
+  if( __builtin_cpu_supports( "avx2" ) )
+    return 4;
+#endif
+  return 1;
+}
+
+static size_t blake2b_many_selected = 0;
+
+size_t blake2b_many_lanes( void )
+{
+  if( blake2b_many_selected == 0 )
+    blake2b_many_selected = blake2b_many_supported();
+  return blake2b_many_selected;
+}
+
+int blake2b_many_set_lanes( size_t lanes )
+{
+  size_t supported = blake2b_many_supported();
+  if( lanes != 1 && lanes != 4 && lanes != 8 )
+    return -1;
+  if( lanes > supported )
+    return -1;
+  blake2b_many_selected = lanes;
+  return 0;
+}
+
+int blake2b_many( blake2b_job *jobs, size_t count )
+{
+  size_t lanes = blake2b_many_lanes();
+  size_t i;
+
+  for( i = 0; i < count; ++i ) {
+    if( jobs[i].out == NULL || jobs[i].outlen == 0 || jobs[i].outlen > BLAKE2B_OUTBYTES )
+      return -1;
+    if( jobs[i].in == NULL && jobs[i].inlen > 0 )
+      return -1;
+    if( jobs[i].param != NULL && ( jobs[i].param->digest_length != jobs[i].outlen ||
+                                   jobs[i].param->key_length != 0 ) )
+      return -1;
+  }
+
+#if BLAKE2B_MB_X86
+  if( lanes > 1 ) {
+    while( count >= 2 ) {
+      size_t n = count < lanes ? count : lanes;
+      blake2b_many_lanes_run( jobs, n, lanes, lanes == 8 ? blake2b_compress_x8 : blake2b_compress_x4 );
+      jobs += n;
+      count -= n;
+    }
+  }
+#endif
+  /* a single input is no faster in a lane of its own */
+  for( i = 0; i < count; ++i ) {
+    blake2b_state S[1];
+    if( jobs[i].param != NULL ) {
+      blake2b_init_param( S, jobs[i].param );
+    } else if( blake2b_init( S, jobs[i].outlen ) < 0 ) {
+      return -1;
+    }
+    blake2b_update( S, jobs[i].in, jobs[i].inlen );
+    if( blake2b_final( S, jobs[i].out, jobs[i].outlen ) < 0 )
+      return -1;
+  }
+  return 0;
+}
+
+#if !BLAKE2B_MB_X86
+int blake2b_many_stripes( blake2b_state *S[4], const uint8_t *in, size_t stripes )
+{
+  (void)S;
+  (void)in;
+  (void)stripes;
+  return -1;
+}
+#endif
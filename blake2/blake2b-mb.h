@@ -0,0 +1,53 @@
+/*
+   Multi-buffer BLAKE2b
+
+   Hashes independent inputs side by side, one input per 64-bit SIMD lane:
+   8 lanes with AVX-512, 4 with AVX2, and one input at a time through
+   blake2b() elsewhere. Meant for many short inputs such as message IDs.
+*/
+#ifndef BLAKE2B_MB_H
+#define BLAKE2B_MB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "blake2.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+  enum blake2b_mb_constant
+  {
+    BLAKE2B_MB_MAX_LANES = 8
+  };
+
+  typedef struct blake2b_job__
+  {
+    uint8_t *out;
+    size_t outlen;     /* 1 to BLAKE2B_OUTBYTES, unkeyed */
+    const void *in;
+    size_t inlen;
+    const blake2b_param *param; /* NULL for the default parameters */
+  } blake2b_job;
+
+  /* Returns -1 if a job has no output or an invalid output length */
+  int blake2b_many( blake2b_job *jobs, size_t count );
+  /* Inputs hashed at once, the widest the CPU supports by default */
+  size_t blake2b_many_lanes( void );
+  /* 1, 4 or 8, returns -1 if the CPU does not support it */
+  int blake2b_many_set_lanes( size_t lanes );
+
+  /*
+     Compresses stripes of 4 blocks into 4 states, block i of each stripe
+     into S[i], none of them as a last block. This is the leaf layer of
+     BLAKE2bp. Returns -1 without 4 lanes, the caller hashes the leaves one by
+     one then.
+  */
+  int blake2b_many_stripes( blake2b_state *S[4], const uint8_t *in, size_t stripes );
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
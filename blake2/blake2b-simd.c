@@ -0,0 +1,497 @@
+/*
+   BLAKE2b compression backends
+
+   Written after the SSE and NEON implementations of the BLAKE2 reference
+   source code package by Samuel Neves. You may use this under the terms of
+   the CC0, the OpenSSL Licence, or the Apache Public License 2.0, at your
+   option.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2.h"
+#include "blake2-impl.h"
+#include "blake2b-backend.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BLAKE2B_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define BLAKE2B_NEON 1
+#include <arm_neon.h>
+#endif
+
+static const uint64_t blake2b_IV[8] =
+{
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] =
+{
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 } ,
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 } ,
+  { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 } ,
+  {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 } ,
+  {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 } ,
+  {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 } ,
+  { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 } ,
+  { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 } ,
+  {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 } ,
+  { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0 } ,
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 } ,
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+#define ROUNDS(ROUND) \
+  do {                \
+    ROUND( 0 );       \
+    ROUND( 1 );       \
+    ROUND( 2 );       \
+    ROUND( 3 );       \
+    ROUND( 4 );       \
+    ROUND( 5 );       \
+    ROUND( 6 );       \
+    ROUND( 7 );       \
+    ROUND( 8 );       \
+    ROUND( 9 );       \
+    ROUND( 10 );      \
+    ROUND( 11 );      \
+  } while(0)
+
+/*
+   Unrolled scalar version: the state lives in locals and every message index
+   is a constant, which leaves a 32-bit core like the Cortex-M with plain
+   register moves instead of indexed loads.
+*/
+#define UG(r,i,a,b,c,d)                      \
+  do {                                       \
+    a = a + b + m[blake2b_sigma[r][2*i+0]];  \
+    d = rotr64(d ^ a, 32);                   \
+    c = c + d;                               \
+    b = rotr64(b ^ c, 24);                   \
+    a = a + b + m[blake2b_sigma[r][2*i+1]];  \
+    d = rotr64(d ^ a, 16);                   \
+    c = c + d;                               \
+    b = rotr64(b ^ c, 63);                   \
+  } while(0)
+
+#define UROUND(r)                  \
+  do {                             \
+    UG(r,0,v0,v4,v8,v12);          \
+    UG(r,1,v1,v5,v9,v13);          \
+    UG(r,2,v2,v6,v10,v14);         \
+    UG(r,3,v3,v7,v11,v15);         \
+    UG(r,4,v0,v5,v10,v15);         \
+    UG(r,5,v1,v6,v11,v12);         \
+    UG(r,6,v2,v7,v8,v13);          \
+    UG(r,7,v3,v4,v9,v14);          \
+  } while(0)
+
+static void blake2b_compress_unrolled( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+{
+  uint64_t m[16];
+  size_t i;
+
+  for( i = 0; i < 16; ++i ) {
+    m[i] = load64( block + i * sizeof( m[i] ) );
+  }
+
+  {
+    uint64_t v0 = S->h[0], v1 = S->h[1], v2 = S->h[2], v3 = S->h[3];
+    uint64_t v4 = S->h[4], v5 = S->h[5], v6 = S->h[6], v7 = S->h[7];
+    uint64_t v8 = blake2b_IV[0], v9 = blake2b_IV[1];
+    uint64_t v10 = blake2b_IV[2], v11 = blake2b_IV[3];
+    uint64_t v12 = blake2b_IV[4] ^ S->t[0], v13 = blake2b_IV[5] ^ S->t[1];
+    uint64_t v14 = blake2b_IV[6] ^ S->f[0], v15 = blake2b_IV[7] ^ S->f[1];
+
+    ROUNDS( UROUND );
+
+    S->h[0] ^= v0 ^ v8;
+    S->h[1] ^= v1 ^ v9;
+    S->h[2] ^= v2 ^ v10;
+    S->h[3] ^= v3 ^ v11;
+    S->h[4] ^= v4 ^ v12;
+    S->h[5] ^= v5 ^ v13;
+    S->h[6] ^= v6 ^ v14;
+    S->h[7] ^= v7 ^ v15;
+  }
+}
+
+#undef UG
+#undef UROUND
+
+#if BLAKE2B_X86 || BLAKE2B_NEON
+/*
+   The message words of each round in the order the vector rounds take them:
+   the first words of the four column steps, the second words, then the same
+   for the diagonal steps. The indices are constants once the rounds are
+   unrolled, so each pair of words costs one shuffle of message registers;
+   storing the permuted words and loading them back as vectors would stall
+   on store forwarding.
+*/
+static const uint8_t blake2b_vector_sigma[12][16] =
+{
+  {  0,  2,  4,  6,  1,  3,  5,  7,  8, 10, 12, 14,  9, 11, 13, 15 } ,
+  { 14,  4,  9, 13, 10,  8, 15,  6,  1,  0, 11,  5, 12,  2,  7,  3 } ,
+  { 11, 12,  5, 15,  8,  0,  2, 13, 10,  3,  7,  9, 14,  6,  1,  4 } ,
+  {  7,  3, 13, 11,  9,  1, 12, 14,  2,  5,  4, 15,  6, 10,  0,  8 } ,
+  {  9,  5,  2, 10,  0,  7,  4, 15, 14, 11,  6,  3,  1, 12,  8, 13 } ,
+  {  2,  6,  0,  8, 12, 10, 11,  3,  4,  7, 15,  1, 13,  5, 14,  9 } ,
+  { 12,  1, 14,  4,  5, 15, 13, 10,  0,  6,  9,  8,  7,  3,  2, 11 } ,
+  { 13,  7, 12,  3, 11, 14,  1,  9,  5, 15,  8,  2,  0,  4,  6, 10 } ,
+  {  6, 14, 11,  0, 15,  9,  3,  8, 12, 13,  1, 10,  2,  7,  4,  5 } ,
+  { 10,  8,  7,  1,  2,  4,  6,  5, 15,  9,  3, 13, 11, 14, 12,  0 } ,
+  {  0,  2,  4,  6,  1,  3,  5,  7,  8, 10, 12, 14,  9, 11, 13, 15 } ,
+  { 14,  4,  9, 13, 10,  8, 15,  6,  1,  0, 11,  5, 12,  2,  7,  3 }
+};
+#endif
+
+#if BLAKE2B_X86
+/*
+   Rows of the state in two 128-bit registers each: row1l = (v0, v1),
+   row1h = (v2, v3) and so on. G runs on all four columns, then on all four
+   diagonals after rotating rows 2 to 4.
+*/
+__attribute__((target("sse2"), always_inline))
+static inline __m128i blake2b_pair_sse( const __m128i mm[8], unsigned a, unsigned b )
+{
+  const __m128i x = mm[a / 2], y = mm[b / 2];
+  switch( ( a & 1 ) * 2 + ( b & 1 ) )
+  {
+    case 0:  return _mm_unpacklo_epi64( x, y );
+    case 1:  return _mm_castpd_si128( _mm_move_sd( _mm_castsi128_pd( y ), _mm_castsi128_pd( x ) ) );
+    case 2:  return _mm_castpd_si128( _mm_shuffle_pd( _mm_castsi128_pd( x ), _mm_castsi128_pd( y ), 1 ) );
+    default: return _mm_unpackhi_epi64( x, y );
+  }
+}
+
+#define LOADM(r,i) blake2b_pair_sse( mm, blake2b_vector_sigma[r][i], blake2b_vector_sigma[r][(i) + 1] )
+
+#define G_SSE(b0,b1,ROT24,ROT16)                                         \
+  do {                                                                   \
+    row1l = _mm_add_epi64( _mm_add_epi64( row1l, b0 ), row2l );          \
+    row1h = _mm_add_epi64( _mm_add_epi64( row1h, b1 ), row2h );          \
+    row4l = _mm_shuffle_epi32( _mm_xor_si128( row4l, row1l ), _MM_SHUFFLE(2,3,0,1) ); \
+    row4h = _mm_shuffle_epi32( _mm_xor_si128( row4h, row1h ), _MM_SHUFFLE(2,3,0,1) ); \
+    row3l = _mm_add_epi64( row3l, row4l );                               \
+    row3h = _mm_add_epi64( row3h, row4h );                               \
+    row2l = ROT24( _mm_xor_si128( row2l, row3l ) );                      \
+    row2h = ROT24( _mm_xor_si128( row2h, row3h ) );                      \
+  } while(0)
+
+#define G2_SSE(b0,b1,ROT24,ROT16)                                        \
+  do {                                                                   \
+    row1l = _mm_add_epi64( _mm_add_epi64( row1l, b0 ), row2l );          \
+    row1h = _mm_add_epi64( _mm_add_epi64( row1h, b1 ), row2h );          \
+    row4l = ROT16( _mm_xor_si128( row4l, row1l ) );                      \
+    row4h = ROT16( _mm_xor_si128( row4h, row1h ) );                      \
+    row3l = _mm_add_epi64( row3l, row4l );                               \
+    row3h = _mm_add_epi64( row3h, row4h );                               \
+    row2l = ROT63_SSE( _mm_xor_si128( row2l, row3l ) );                  \
+    row2h = ROT63_SSE( _mm_xor_si128( row2h, row3h ) );                  \
+  } while(0)
+
+#define ROT63_SSE(x) _mm_xor_si128( _mm_srli_epi64( (x), 63 ), _mm_add_epi64( (x), (x) ) )
+#define ROT24_SSE2(x) _mm_xor_si128( _mm_srli_epi64( (x), 24 ), _mm_slli_epi64( (x), 40 ) )
+#define ROT16_SSE2(x) _mm_xor_si128( _mm_srli_epi64( (x), 16 ), _mm_slli_epi64( (x), 48 ) )
+#define ROT24_SSSE3(x) _mm_shuffle_epi8( (x), r24 )
+#define ROT16_SSSE3(x) _mm_shuffle_epi8( (x), r16 )
+
+#define DIAGONALIZE_SSE()                                                \
+  do {                                                                   \
+    __m128i t0 = row4l, t1 = row2l;                                      \
+    row4l = row3l; row3l = row3h; row3h = row4l;                         \
+    row4l = _mm_unpackhi_epi64( row4h, _mm_unpacklo_epi64( t0, t0 ) );  \
+    row4h = _mm_unpackhi_epi64( t0, _mm_unpacklo_epi64( row4h, row4h ) ); \
+    row2l = _mm_unpackhi_epi64( row2l, _mm_unpacklo_epi64( row2h, row2h ) ); \
+    row2h = _mm_unpackhi_epi64( row2h, _mm_unpacklo_epi64( t1, t1 ) );  \
+  } while(0)
+
+#define UNDIAGONALIZE_SSE()                                              \
+  do {                                                                   \
+    __m128i t0 = row3l, t1;                                              \
+    row3l = row3h; row3h = t0;                                           \
+    t0 = row2l; t1 = row4l;                                              \
+    row2l = _mm_unpackhi_epi64( row2h, _mm_unpacklo_epi64( row2l, row2l ) ); \
+    row2h = _mm_unpackhi_epi64( t0, _mm_unpacklo_epi64( row2h, row2h ) ); \
+    row4l = _mm_unpackhi_epi64( row4l, _mm_unpacklo_epi64( row4h, row4h ) ); \
+    row4h = _mm_unpackhi_epi64( row4h, _mm_unpacklo_epi64( t1, t1 ) );  \
+  } while(0)
+
+#define ROUND_SSE(r,ROT24,ROT16)                                         \
+  do {                                                                   \
+    G_SSE( LOADM(r,0), LOADM(r,2), ROT24, ROT16 );                   \
+    G2_SSE( LOADM(r,4), LOADM(r,6), ROT24, ROT16 );                  \
+    DIAGONALIZE_SSE();                                                   \
+    G_SSE( LOADM(r,8), LOADM(r,10), ROT24, ROT16 );                \
+    G2_SSE( LOADM(r,12), LOADM(r,14), ROT24, ROT16 );               \
+    UNDIAGONALIZE_SSE();                                                 \
+  } while(0)
+
+#define ROUND_SSE2(r) ROUND_SSE(r, ROT24_SSE2, ROT16_SSE2)
+#define ROUND_SSSE3(r) ROUND_SSE(r, ROT24_SSSE3, ROT16_SSSE3)
+
+#define COMPRESS_SSE(ROUND)                                              \
+  do {                                                                   \
+    __m128i mm[8];                                                       \
+    size_t i;                                                            \
+    __m128i row1l, row1h, row2l, row2h, row3l, row3h, row4l, row4h;      \
+    const __m128i h01 = _mm_loadu_si128( (const __m128i *)&S->h[0] );   \
+    const __m128i h23 = _mm_loadu_si128( (const __m128i *)&S->h[2] );   \
+    const __m128i h45 = _mm_loadu_si128( (const __m128i *)&S->h[4] );   \
+    const __m128i h67 = _mm_loadu_si128( (const __m128i *)&S->h[6] );   \
+    for( i = 0; i < 8; ++i ) {                                           \
+      mm[i] = _mm_loadu_si128( (const __m128i *)( block + i * 16 ) );   \
+    }                                                                    \
+    row1l = h01; row1h = h23; row2l = h45; row2h = h67;                  \
+    row3l = _mm_loadu_si128( (const __m128i *)&blake2b_IV[0] );         \
+    row3h = _mm_loadu_si128( (const __m128i *)&blake2b_IV[2] );         \
+    row4l = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)&blake2b_IV[4] ), \
+                           _mm_loadu_si128( (const __m128i *)&S->t[0] ) ); \
+    row4h = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)&blake2b_IV[6] ), \
+                           _mm_loadu_si128( (const __m128i *)&S->f[0] ) ); \
+    ROUNDS( ROUND );                                                     \
+    _mm_storeu_si128( (__m128i *)&S->h[0], _mm_xor_si128( h01, _mm_xor_si128( row1l, row3l ) ) ); \
+    _mm_storeu_si128( (__m128i *)&S->h[2], _mm_xor_si128( h23, _mm_xor_si128( row1h, row3h ) ) ); \
+    _mm_storeu_si128( (__m128i *)&S->h[4], _mm_xor_si128( h45, _mm_xor_si128( row2l, row4l ) ) ); \
+    _mm_storeu_si128( (__m128i *)&S->h[6], _mm_xor_si128( h67, _mm_xor_si128( row2h, row4h ) ) ); \
+  } while(0)
+
+__attribute__((target("sse2")))
+static void blake2b_compress_sse2( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+{
+  COMPRESS_SSE( ROUND_SSE2 );
+}
+
+__attribute__((target("ssse3")))
+static void blake2b_compress_ssse3( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+{
+  const __m128i r16 = _mm_setr_epi8( 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9 );
+  const __m128i r24 = _mm_setr_epi8( 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10 );
+  COMPRESS_SSE( ROUND_SSSE3 );
+}
+
+/*
+   One row per 256-bit register, diagonals by permuting whole rows.
+*/
+#define LOADM4(r,i) _mm256_inserti128_si256( _mm256_castsi128_si256( LOADM(r,i) ), LOADM(r,(i) + 2), 1 )
+
+#define G1_AVX2(b0)                                                      \
+  do {                                                                   \
+    a = _mm256_add_epi64( _mm256_add_epi64( a, b0 ), b );                \
+    d = _mm256_shuffle_epi32( _mm256_xor_si256( d, a ), _MM_SHUFFLE(2,3,0,1) ); \
+    c = _mm256_add_epi64( c, d );                                        \
+    b = _mm256_shuffle_epi8( _mm256_xor_si256( b, c ), r24 );            \
+  } while(0)
+
+#define G2_AVX2(b0)                                                      \
+  do {                                                                   \
+    a = _mm256_add_epi64( _mm256_add_epi64( a, b0 ), b );                \
+    d = _mm256_shuffle_epi8( _mm256_xor_si256( d, a ), r16 );            \
+    c = _mm256_add_epi64( c, d );                                        \
+    b = _mm256_xor_si256( b, c );                                        \
+    b = _mm256_xor_si256( _mm256_srli_epi64( b, 63 ), _mm256_add_epi64( b, b ) ); \
+  } while(0)
+
+#define ROUND_AVX2(r)                                                    \
+  do {                                                                   \
+    G1_AVX2( LOADM4(r,0) )      ;                                        \
+    G2_AVX2( LOADM4(r,4) )      ;                                        \
+    b = _mm256_permute4x64_epi64( b, _MM_SHUFFLE(0,3,2,1) );             \
+    c = _mm256_permute4x64_epi64( c, _MM_SHUFFLE(1,0,3,2) );             \
+    d = _mm256_permute4x64_epi64( d, _MM_SHUFFLE(2,1,0,3) );             \
+    G1_AVX2( LOADM4(r,8) )         ;                                     \
+    G2_AVX2( LOADM4(r,12) )        ;                                     \
+    b = _mm256_permute4x64_epi64( b, _MM_SHUFFLE(2,1,0,3) );             \
+    c = _mm256_permute4x64_epi64( c, _MM_SHUFFLE(1,0,3,2) );             \
+    d = _mm256_permute4x64_epi64( d, _MM_SHUFFLE(0,3,2,1) );             \
+  } while(0)
+
+__attribute__((target("avx2")))
+static void blake2b_compress_avx2( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+{
+  const __m256i r16 = _mm256_setr_epi8( 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                        2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9 );
+  const __m256i r24 = _mm256_setr_epi8( 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                        3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10 );
+  __m128i mm[8];
+  size_t i;
+  const __m256i h0 = _mm256_loadu_si256( (const __m256i *)&S->h[0] );
+  const __m256i h1 = _mm256_loadu_si256( (const __m256i *)&S->h[4] );
+  __m256i a, b, c, d;
+
+  for( i = 0; i < 8; ++i ) {
+    mm[i] = _mm_loadu_si128( (const __m128i *)( block + i * 16 ) );
+  }
+  a = h0;
+  b = h1;
+  c = _mm256_loadu_si256( (const __m256i *)&blake2b_IV[0] );
+  d = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i *)&blake2b_IV[4] ),
+                        _mm256_set_epi64x( (int64_t)S->f[1], (int64_t)S->f[0],
+                                           (int64_t)S->t[1], (int64_t)S->t[0] ) );
+
+  ROUNDS( ROUND_AVX2 );
+
+  _mm256_storeu_si256( (__m256i *)&S->h[0], _mm256_xor_si256( h0, _mm256_xor_si256( a, c ) ) );
+  _mm256_storeu_si256( (__m256i *)&S->h[4], _mm256_xor_si256( h1, _mm256_xor_si256( b, d ) ) );
+}
+#endif
+
+#if BLAKE2B_NEON
+/*
+   Same row layout as SSE, vext does the diagonal rotation.
+*/
+__attribute__((always_inline))
+static inline uint64x2_t blake2b_pair_neon( const uint64x2_t mm[8], unsigned a, unsigned b )
+{
+  const uint64x1_t x = ( a & 1 ) ? vget_high_u64( mm[a / 2] ) : vget_low_u64( mm[a / 2] );
+  const uint64x1_t y = ( b & 1 ) ? vget_high_u64( mm[b / 2] ) : vget_low_u64( mm[b / 2] );
+  return vcombine_u64( x, y );
+}
+
+#define LOADM_NEON(r,i) blake2b_pair_neon( mm, blake2b_vector_sigma[r][i], blake2b_vector_sigma[r][(i) + 1] )
+
+#define ROTR_NEON(x,n) veorq_u64( vshrq_n_u64( (x), n ), vshlq_n_u64( (x), 64 - n ) )
+#define ROT32_NEON(x) vreinterpretq_u64_u32( vrev64q_u32( vreinterpretq_u32_u64( x ) ) )
+
+#define G_NEON(b0,b1,ROTD,ROTB)                                          \
+  do {                                                                   \
+    row1l = vaddq_u64( vaddq_u64( row1l, b0 ), row2l );                  \
+    row1h = vaddq_u64( vaddq_u64( row1h, b1 ), row2h );                  \
+    row4l = ROTD( veorq_u64( row4l, row1l ) );                           \
+    row4h = ROTD( veorq_u64( row4h, row1h ) );                           \
+    row3l = vaddq_u64( row3l, row4l );                                   \
+    row3h = vaddq_u64( row3h, row4h );                                   \
+    row2l = ROTB( veorq_u64( row2l, row3l ) );                           \
+    row2h = ROTB( veorq_u64( row2h, row3h ) );                           \
+  } while(0)
+
+#define ROT24_NEON(x) ROTR_NEON(x, 24)
+#define ROT16_NEON(x) ROTR_NEON(x, 16)
+#define ROT63_NEON(x) ROTR_NEON(x, 63)
+
+#define ROUND_NEON(r)                                                    \
+  do {                                                                   \
+    uint64x2_t t0, t1;                                                   \
+    G_NEON( LOADM_NEON(r,0), LOADM_NEON(r,2), ROT32_NEON, ROT24_NEON ); \
+    G_NEON( LOADM_NEON(r,4), LOADM_NEON(r,6), ROT16_NEON, ROT63_NEON ); \
+    t0 = vextq_u64( row2l, row2h, 1 ); t1 = vextq_u64( row2h, row2l, 1 ); \
+    row2l = t0; row2h = t1;                                              \
+    t0 = row3l; row3l = row3h; row3h = t0;                               \
+    t0 = vextq_u64( row4h, row4l, 1 ); t1 = vextq_u64( row4l, row4h, 1 ); \
+    row4l = t0; row4h = t1;                                              \
+    G_NEON( LOADM_NEON(r,8), LOADM_NEON(r,10), ROT32_NEON, ROT24_NEON ); \
+    G_NEON( LOADM_NEON(r,12), LOADM_NEON(r,14), ROT16_NEON, ROT63_NEON ); \
+    t0 = vextq_u64( row2h, row2l, 1 ); t1 = vextq_u64( row2l, row2h, 1 ); \
+    row2l = t0; row2h = t1;                                              \
+    t0 = row3l; row3l = row3h; row3h = t0;                               \
+    t0 = vextq_u64( row4l, row4h, 1 ); t1 = vextq_u64( row4h, row4l, 1 ); \
+    row4l = t0; row4h = t1;                                              \
+  } while(0)
+
+static void blake2b_compress_neon( blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+{
+  uint64x2_t mm[8];
+  size_t i;
+  const uint64x2_t h01 = vld1q_u64( &S->h[0] );
+  const uint64x2_t h23 = vld1q_u64( &S->h[2] );
+  const uint64x2_t h45 = vld1q_u64( &S->h[4] );
+  const uint64x2_t h67 = vld1q_u64( &S->h[6] );
+  uint64x2_t row1l = h01, row1h = h23, row2l = h45, row2h = h67;
+  uint64x2_t row3l = vld1q_u64( &blake2b_IV[0] );
+  uint64x2_t row3h = vld1q_u64( &blake2b_IV[2] );
+  uint64x2_t row4l = veorq_u64( vld1q_u64( &blake2b_IV[4] ), vld1q_u64( &S->t[0] ) );
+  uint64x2_t row4h = veorq_u64( vld1q_u64( &blake2b_IV[6] ), vld1q_u64( &S->f[0] ) );
+
+  for( i = 0; i < 8; ++i ) {
+    mm[i] = vreinterpretq_u64_u8( vld1q_u8( block + i * 16 ) );
+  }
+
+  ROUNDS( ROUND_NEON );
+
+  vst1q_u64( &S->h[0], veorq_u64( h01, veorq_u64( row1l, row3l ) ) );
+  vst1q_u64( &S->h[2], veorq_u64( h23, veorq_u64( row1h, row3h ) ) );
+  vst1q_u64( &S->h[4], veorq_u64( h45, veorq_u64( row2l, row4l ) ) );
+  vst1q_u64( &S->h[6], veorq_u64( h67, veorq_u64( row2h, row4h ) ) );
+}
+#endif
+
+/*
+   Slowest first, the last one the CPU supports is the default. On x86-64 the
+   scalar code already works on 64-bit registers and beats SSE2, which has no
+   byte shuffle for the 16 and 24 bit rotations.
+*/
+static const blake2b_backend blake2b_all_backends[] =
+{
+  { "ref", blake2b_compress_ref },
+#if BLAKE2B_X86
+  { "sse2", blake2b_compress_sse2 },
+#endif
+  { "unrolled", blake2b_compress_unrolled },
+#if BLAKE2B_X86
+  { "ssse3", blake2b_compress_ssse3 },
+  { "avx2", blake2b_compress_avx2 },
+#endif
+#if BLAKE2B_NEON
+  { "neon", blake2b_compress_neon },
+#endif
+};
+
+#define BLAKE2B_BACKEND_COUNT ( sizeof( blake2b_all_backends ) / sizeof( blake2b_all_backends[0] ) )
+
+static int blake2b_supported( const blake2b_backend *backend )
+{
+#if BLAKE2B_X86
+  __builtin_cpu_init();
+  if( backend->compress == blake2b_compress_sse2 )
+    return __builtin_cpu_supports( "sse2" );
+  if( backend->compress == blake2b_compress_ssse3 )
+    return __builtin_cpu_supports( "ssse3" );
+  if( backend->compress == blake2b_compress_avx2 )
+    return __builtin_cpu_supports( "avx2" );
+#endif
+  (void)backend;
+  return 1;
+}
+
+static const blake2b_backend *blake2b_selected = NULL;
+
+const blake2b_backend *blake2b_backends( size_t *count )
+{
+  size_t n = 0;
+  while( n < BLAKE2B_BACKEND_COUNT && blake2b_supported( &blake2b_all_backends[n] ) )
+    ++n;
+  *count = n;
+  return blake2b_all_backends;
+}
+
+const blake2b_backend *blake2b_get_backend( void )
+{
+  /* a race on the first call picks the same backend twice */
+  if( blake2b_selected == NULL )
+  {
+    size_t count;
+    const blake2b_backend *backends = blake2b_backends( &count );
+    blake2b_selected = &backends[count - 1];
+  }
+  return blake2b_selected;
+}
+
+int blake2b_set_backend( const char *name )
+{
+  size_t i, count;
+  const blake2b_backend *backends = blake2b_backends( &count );
+  for( i = 0; i < count; ++i )
+  {
+    if( strcmp( backends[i].name, name ) == 0 )
+    {
+      blake2b_selected = &backends[i];
+      return 0;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,191 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Aggregating publisher of sensor samples
+ *
+ */
+
+#include "batchPublisher.h"
+
+static char const samples_key[] = ",\"samples\":[";
+
+batchPublisher::batchPublisher(iotaAPI &iota, EventQueue *queue,
+                               const std::string &index, const std::string &id,
+                               const std::vector<std::string> &fields)
+    : _iota(iota), _queue(queue), _index(index), _fields(fields.size()),
+      _count(0), _t0(0), _timer(0), _generation(0), _flush_pending(false),
+      _in_flight(false) {
+  memset(&_stats, 0, sizeof(_stats));
+  // JSON hex encodes the index and data into the message buffer
+  _max_bytes = min((size_t)BATCH_MAX_BYTES,
+                   min((size_t)(IOTA_MESSAGE_MAX_BYTES - IOTA_MESSAGE_OVERHEAD),
+                       (size_t)BATCH_BUF_BYTES) -
+                       index.length());
+
+  // the part of the payload which is the same for every batch
+  _header = "{\"ID\":\"" + id + "\",\"fields\":[";
+  for (size_t i = 0; i < fields.size(); i++) {
+    _header += (i ? ",\"" : "\"") + fields[i] + "\"";
+  }
+  _header += "],\"t0\":";
+}
+
+batchPublisher::~batchPublisher() {
+  // a batch is fetching tips and posting at most
+  close(2 * HTTP_TOTAL_TIMEOUT);
+  if (_timer) {
+    _queue->cancel(_timer);
+  }
+}
+
+static void appendRow(std::string &rows, long offset, const float *values,
+                       size_t count) {
+  char num[24];
+  snprintf(num, sizeof(num), "%s[%ld", rows.empty() ? "" : ",", offset);
+  rows += num;
+  for (size_t i = 0; i < count; i++) {
+    snprintf(num, sizeof(num), ",%.2f", values[i]);
+    rows += num;
+  }
+  rows += "]";
+}
+
+size_t batchPublisher::payloadLen(size_t rows_len) {
+  char t0[24];
+  int t0_len = snprintf(t0, sizeof(t0), "%ld", (long)_t0);
+  return _header.length() + t0_len + strlen(samples_key) + rows_len + 2;
+}
+
+int batchPublisher::add(time_t time, const float *values) {
+  std::string rows;
+
+  _mutex.lock();
+  if (_count == 0) {
+    _t0 = time;
+  }
+  rows = _rows;
+  appendRow(rows, time - _t0, values, _fields);
+  if (_count >= BATCH_SAMPLES || payloadLen(rows.length()) > _max_bytes) {
+    // the sample goes into the next batch
+    sendBatch();
+    if (_count > 0) {
+      // the previous batch is still in flight
+      _stats.dropped++;
+      _mutex.unlock();
+      return -1;
+    }
+    _t0 = time;
+    rows.clear();
+    appendRow(rows, 0, values, _fields);
+  }
+  if (payloadLen(rows.length()) > _max_bytes) {
+    printf("sample larger than a batch\n");
+    _stats.dropped++;
+    _mutex.unlock();
+    return -1;
+  }
+
+  _rows.swap(rows);
+  if (++_count == 1) {
+    _generation++;
+    _timer = _queue->call_in(chrono::milliseconds(BATCH_INTERVAL),
+                             callback(this, &batchPublisher::onTimer),
+                             _generation);
+  }
+  if (_count >= BATCH_SAMPLES || _flush_pending) {
+    sendBatch();
+  }
+  _mutex.unlock();
+  return 0;
+}
+
+void batchPublisher::sendBatch() {
+  if (_count == 0) {
+    return;
+  }
+  if (_in_flight) {
+    _flush_pending = true;
+    return;
+  }
+
+  std::string payload;
+  payload.reserve(payloadLen(_rows.length()));
+  char t0[24];
+  snprintf(t0, sizeof(t0), "%ld", (long)_t0);
+  payload.append(_header).append(t0).append(samples_key).append(_rows);
+  payload.append("]}");
+  if (_iota.sendIndexationAsync(_index, payload,
+                                callback(this, &batchPublisher::onSent)) !=
+      0) {
+    // the client is busy, try again with the next sample
+    _flush_pending = true;
+    return;
+  }
+
+  _in_flight = true;
+  _flush_pending = false;
+  _stats.batches++;
+  _stats.samples += _count;
+  _stats.bytes += payload.length();
+  _stats.last_fill = _count * 100 / BATCH_SAMPLES;
+  if (_timer) {
+    _queue->cancel(_timer);
+    _timer = 0;
+  }
+  _rows.clear();
+  _count = 0;
+}
+
+void batchPublisher::onTimer(uint32_t generation) {
+  _mutex.lock();
+  // a timer which fired while its batch was sent belongs to no batch now
+  if (generation == _generation) {
+    _timer = 0;
+    sendBatch();
+  }
+  _mutex.unlock();
+}
+
+void batchPublisher::onSent(int ret) {
+  _mutex.lock();
+  _in_flight = false;
+  if (ret != 0) {
+    _stats.failed++;
+  }
+  if (_flush_pending) {
+    sendBatch();
+  }
+  _mutex.unlock();
+}
+
+void batchPublisher::flush() {
+  _mutex.lock();
+  sendBatch();
+  _mutex.unlock();
+}
+
+int batchPublisher::close(uint32_t timeout_ms) {
+  auto deadline = Kernel::Clock::now() + chrono::milliseconds(timeout_ms);
+  flush();
+  while (_count > 0 || _in_flight) {
+    if (Kernel::Clock::now() >= deadline) {
+      printf("batch not sent before shutdown\n");
+      return -1;
+    }
+    ThisThread::sleep_for(50ms);
+    if (!_in_flight) {
+      flush();
+    }
+  }
+  return 0;
+}
+
+uint8_t batchPublisher::fillRatio() {
+  if (_stats.batches == 0) {
+    return 0;
+  }
+  return (uint64_t)_stats.samples * 100 /
+         ((uint64_t)_stats.batches * BATCH_SAMPLES);
+}
@@ -0,0 +1,107 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Aggregating publisher of sensor samples
+ *
+ * Buffers samples until the batch has BATCH_SAMPLES of them, BATCH_INTERVAL
+ * has passed since the first one or the next one would not fit into
+ * BATCH_MAX_BYTES, and sends them as one indexation message. Field names are
+ * written once per batch and sample times as offsets to the first one:
+ *
+ * {"ID":"B-L4S5I-IOT01A","fields":["temp","humi"],"t0":1614500719,
+ *  "samples":[[0,19.04,30.10],[10,19.05,30.02]]}
+ */
+
+#ifndef __BATCH_PUBLISHER_H__
+#define __BATCH_PUBLISHER_H__
+
+#include "iotaAPI.h"
+#include "main_config.h"
+#include "mbed.h"
+#include <string>
+#include <vector>
+
+#define IOTA_MESSAGE_MAX_BYTES 32768 // limit of the node
+// message fields besides the data, the largest is JSON with all parents:
+// hex ID, quotes and comma for each, then the keys and braces around them
+#define IOTA_JSON_PARENT_BYTES (2 * IOTA_MESSAGE_ID_BYTES + 3)
+#define IOTA_JSON_KEYS_BYTES 96
+#define IOTA_MESSAGE_OVERHEAD                                                  \
+  (IOTA_MAX_PARENTS * IOTA_JSON_PARENT_BYTES + IOTA_JSON_KEYS_BYTES)
+
+// a batch is hex encoded into the message buffer when sent as JSON
+#define BATCH_BUF_BYTES ((MESSAGE_BUF_SIZE - IOTA_MESSAGE_OVERHEAD) / 2)
+#if BATCH_MAX_BYTES > BATCH_BUF_BYTES
+#error "batch-max-bytes does not fit into message-buf, raise message-buf"
+#endif
+
+typedef struct {
+  uint32_t batches;  // messages queued for sending
+  uint32_t samples;  // samples in those messages
+  uint32_t dropped;  // samples lost while the previous batch was in flight
+  uint32_t failed;   // messages the node did not accept
+  uint32_t bytes;    // payload bytes
+  uint8_t last_fill; // samples of the last batch in percent of BATCH_SAMPLES
+} batch_stats_t;
+
+class batchPublisher {
+public:
+  /**
+   * @brief Create a publisher sending through an asynchronous IOTA client
+   *
+   * @param[in] iota The client, set up with the event queue
+   * @param[in] queue The event queue of the client
+   * @param[in] index The index of the messages
+   * @param[in] id The sensor ID
+   * @param[in] fields The names of the sample values
+   */
+  batchPublisher(iotaAPI &iota, EventQueue *queue, const std::string &index,
+                 const std::string &id, const std::vector<std::string> &fields);
+  ~batchPublisher();
+
+  /**
+   * @brief Add a sample to the batch
+   *
+   * @param[in] time The sample time
+   * @param[in] values One value per field
+   * @return int 0 on success, -1 if the sample was dropped
+   */
+  int add(time_t time, const float *values);
+  void flush(); // send the buffered samples now
+
+  /**
+   * @brief Send the buffered samples and wait for the node
+   *
+   * @param[in] timeout_ms The longest time to wait
+   * @return int 0 if nothing is left to send, -1 on timeout
+   */
+  int close(uint32_t timeout_ms);
+  const batch_stats_t &stats() { return _stats; }
+  uint8_t fillRatio(); // average batch fill in percent of BATCH_SAMPLES
+
+private:
+  void sendBatch();
+  void onTimer(uint32_t generation);
+  void onSent(int ret);
+  size_t payloadLen(size_t rows_len);
+
+  iotaAPI &_iota;
+  EventQueue *_queue;
+  std::string _index;
+  std::string _header; // the payload up to t0
+  size_t _fields;
+  size_t _max_bytes;
+  std::string _rows;   // comma separated sample arrays
+  size_t _count;       // samples in _rows
+  time_t _t0;          // time of the first sample
+  int _timer;          // flushes the batch after BATCH_INTERVAL
+  uint32_t _generation; // of the batch in _rows, tells stale timers apart
+  bool _flush_pending; // send the batch once the client is free
+  volatile bool _in_flight;
+  batch_stats_t _stats;
+  Mutex _mutex;
+};
+
+#endif
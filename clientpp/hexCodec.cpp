@@ -0,0 +1,299 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Hex encoding and decoding into caller buffers
+ *
+ */
+
+#include <string.h>
+
+#include "hexCodec.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define HEX_NEON 1
+#include <arm_neon.h>
+#endif
+
+static const char hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+// 0xff for characters which are not hex digits
+static const uint8_t hex_values[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+typedef void (*encode_fn_t)(char *hex, uint8_t const *bin, size_t len);
+// returns 0 if all characters were hex digits
+typedef int (*decode_fn_t)(uint8_t *bin, char const *hex, size_t len);
+
+static void encode_table(char *hex, uint8_t const *bin, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    memcpy(hex + 2 * i, hex_pairs + 2 * bin[i], 2);
+  }
+}
+
+static int decode_table(uint8_t *bin, char const *hex, size_t len) {
+  uint8_t invalid = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint8_t hi = hex_values[(uint8_t)hex[2 * i]];
+    uint8_t lo = hex_values[(uint8_t)hex[2 * i + 1]];
+    invalid |= hi | lo;
+    bin[i] = (hi << 4) | (lo & 0x0f);
+  }
+  // valid digits never set the upper nibble
+  return invalid & 0xf0 ? -1 : 0;
+}
+
+#if HEX_X86
+// nibbles to '0'-'9' and 'a'-'f'
+__attribute__((target("sse2"))) static inline __m128i
+nibbles_sse2(__m128i n) {
+  __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)),
+                                  _mm_set1_epi8('a' - '0' - 10));
+  return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letters);
+}
+
+__attribute__((target("sse2"))) static void
+encode_sse2(char *hex, uint8_t const *bin, size_t len) {
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i b = _mm_loadu_si128((__m128i const *)(bin + i));
+    __m128i hi = nibbles_sse2(_mm_and_si128(_mm_srli_epi16(b, 4), mask));
+    __m128i lo = nibbles_sse2(_mm_and_si128(b, mask));
+    _mm_storeu_si128((__m128i *)(hex + 2 * i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)(hex + 2 * i + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+  encode_table(hex + 2 * i, bin + i, len - i);
+}
+
+// characters to nibble values, clears *valid lanes of non-hex characters
+__attribute__((target("sse2"))) static inline __m128i
+values_sse2(__m128i c, __m128i *valid) {
+  __m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+  __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                                 _mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1)));
+  *valid = _mm_and_si128(*valid, _mm_or_si128(digit, letter));
+  return _mm_or_si128(
+      _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+      _mm_and_si128(letter, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))));
+}
+
+// 16 characters to 8 bytes in the low half of each 16-bit lane
+__attribute__((target("sse2"))) static inline __m128i
+pairs_sse2(__m128i v) {
+  __m128i hi = _mm_and_si128(v, _mm_set1_epi16(0x00ff));
+  __m128i lo = _mm_srli_epi16(v, 8);
+  return _mm_or_si128(_mm_slli_epi16(hi, 4), lo);
+}
+
+__attribute__((target("sse2"))) static int
+decode_sse2(uint8_t *bin, char const *hex, size_t len) {
+  __m128i valid = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i c0 = _mm_loadu_si128((__m128i const *)(hex + 2 * i));
+    __m128i c1 = _mm_loadu_si128((__m128i const *)(hex + 2 * i + 16));
+    __m128i v0 = pairs_sse2(values_sse2(c0, &valid));
+    __m128i v1 = pairs_sse2(values_sse2(c1, &valid));
+    _mm_storeu_si128((__m128i *)(bin + i), _mm_packus_epi16(v0, v1));
+  }
+  if (_mm_movemask_epi8(valid) != 0xffff) {
+    return -1;
+  }
+  return decode_table(bin + i, hex + 2 * i, len - i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+nibbles_avx2(__m256i n) {
+  __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)),
+                                     _mm256_set1_epi8('a' - '0' - 10));
+  return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')), letters);
+}
+
+__attribute__((target("avx2"))) static void
+encode_avx2(char *hex, uint8_t const *bin, size_t len) {
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i b = _mm256_loadu_si256((__m256i const *)(bin + i));
+    __m256i hi = nibbles_avx2(_mm256_and_si256(_mm256_srli_epi16(b, 4), mask));
+    __m256i lo = nibbles_avx2(_mm256_and_si256(b, mask));
+    // unpacking works per 128-bit lane, put the halves back in order
+    __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    __m256i c = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i *)(hex + 2 * i),
+                        _mm256_permute2x128_si256(a, c, 0x20));
+    _mm256_storeu_si256((__m256i *)(hex + 2 * i + 32),
+                        _mm256_permute2x128_si256(a, c, 0x31));
+  }
+  encode_sse2(hex + 2 * i, bin + i, len - i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+values_avx2(__m256i c, __m256i *valid) {
+  __m256i l = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+  __m256i digit =
+      _mm256_andnot_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('9')),
+                          _mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)));
+  __m256i letter =
+      _mm256_andnot_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8('f')),
+                          _mm256_cmpgt_epi8(l, _mm256_set1_epi8('a' - 1)));
+  *valid = _mm256_and_si256(*valid, _mm256_or_si256(digit, letter));
+  return _mm256_or_si256(
+      _mm256_and_si256(digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+      _mm256_and_si256(letter, _mm256_sub_epi8(l, _mm256_set1_epi8('a' - 10))));
+}
+
+__attribute__((target("avx2"))) static int
+decode_avx2(uint8_t *bin, char const *hex, size_t len) {
+  __m256i valid = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m256i v = values_avx2(
+        _mm256_loadu_si256((__m256i const *)(hex + 2 * i)), &valid);
+    __m256i hi = _mm256_and_si256(v, _mm256_set1_epi16(0x00ff));
+    __m256i r = _mm256_or_si256(_mm256_slli_epi16(hi, 4),
+                                _mm256_srli_epi16(v, 8));
+    // packing works per 128-bit lane, gather the low quad words
+    r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, r), 0x08);
+    _mm_storeu_si128((__m128i *)(bin + i), _mm256_castsi256_si128(r));
+  }
+  if ((uint32_t)_mm256_movemask_epi8(valid) != 0xffffffffu) {
+    return -1;
+  }
+  return decode_table(bin + i, hex + 2 * i, len - i);
+}
+#endif
+
+#if HEX_NEON
+static inline uint8x16_t nibbles_neon(uint8x16_t n) {
+  uint8x16_t letters =
+      vandq_u8(vcgtq_u8(n, vdupq_n_u8(9)), vdupq_n_u8('a' - '0' - 10));
+  return vaddq_u8(vaddq_u8(n, vdupq_n_u8('0')), letters);
+}
+
+static void encode_neon(char *hex, uint8_t const *bin, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t b = vld1q_u8(bin + i);
+    uint8x16x2_t out;
+    out.val[0] = nibbles_neon(vshrq_n_u8(b, 4));
+    out.val[1] = nibbles_neon(vandq_u8(b, vdupq_n_u8(0x0f)));
+    // interleaving store, high nibble first
+    vst2q_u8((uint8_t *)hex + 2 * i, out);
+  }
+  encode_table(hex + 2 * i, bin + i, len - i);
+}
+
+static inline uint8x16_t values_neon(uint8x16_t c, uint8x16_t *valid) {
+  // unsigned wrap around turns range checks into one compare
+  uint8x16_t d = vsubq_u8(c, vdupq_n_u8('0'));
+  uint8x16_t l = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  uint8x16_t digit = vcltq_u8(d, vdupq_n_u8(10));
+  uint8x16_t letter = vcltq_u8(l, vdupq_n_u8(6));
+  *valid = vandq_u8(*valid, vorrq_u8(digit, letter));
+  return vbslq_u8(digit, d, vaddq_u8(l, vdupq_n_u8(10)));
+}
+
+static int decode_neon(uint8_t *bin, char const *hex, size_t len) {
+  uint8x16_t valid = vdupq_n_u8(0xff);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    // deinterleaving load, high nibble characters in val[0]
+    uint8x16x2_t c = vld2q_u8((uint8_t const *)hex + 2 * i);
+    uint8x16_t hi = values_neon(c.val[0], &valid);
+    uint8x16_t lo = values_neon(c.val[1], &valid);
+    vst1q_u8(bin + i, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+  }
+  uint64x2_t v = vreinterpretq_u64_u8(valid);
+  if ((vgetq_lane_u64(v, 0) & vgetq_lane_u64(v, 1)) != UINT64_MAX) {
+    return -1;
+  }
+  return decode_table(bin + i, hex + 2 * i, len - i);
+}
+#endif
+
+typedef struct {
+  encode_fn_t encode;
+  decode_fn_t decode;
+  char const *name;
+} hex_kernel_t;
+
+static hex_kernel_t const *select_kernel() {
+#if HEX_X86
+  static const hex_kernel_t avx2 = {encode_avx2, decode_avx2, "avx2"};
+  static const hex_kernel_t sse2 = {encode_sse2, decode_sse2, "sse2"};
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return &sse2;
+  }
+#elif HEX_NEON
+  static const hex_kernel_t neon = {encode_neon, decode_neon, "neon"};
+  return &neon;
+#endif
+  static const hex_kernel_t table = {encode_table, decode_table, "table"};
+  return &table;
+}
+
+static hex_kernel_t const *kernel() {
+  // selecting twice from two threads is harmless, the result is the same
+  static hex_kernel_t const *selected = NULL;
+  if (!selected) {
+    selected = select_kernel();
+  }
+  return selected;
+}
+
+int hex_encode(char *hex, size_t hex_len, uint8_t const *bin, size_t bin_len) {
+  if (bin_len > hex_len / 2) {
+    return -1;
+  }
+  kernel()->encode(hex, bin, bin_len);
+  return (int)(bin_len * 2);
+}
+
+int hex_decode(uint8_t *bin, size_t bin_len, char const *hex, size_t hex_len) {
+  if (hex_len % 2 || hex_len / 2 > bin_len) {
+    return -1;
+  }
+  if (kernel()->decode(bin, hex, hex_len / 2) != 0) {
+    return -1;
+  }
+  return (int)(hex_len / 2);
+}
+
+char const *hex_kernel() { return kernel()->name; }
@@ -0,0 +1,52 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Hex encoding and decoding into caller buffers
+ *
+ * A table driven implementation runs everywhere. SSE2, AVX2 and NEON kernels
+ * take over on targets which have them, on x86 hosts AVX2 is picked at run
+ * time. It has no Mbed OS dependency and builds on a host as well.
+ */
+
+#ifndef __HEX_CODEC_H__
+#define __HEX_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Encode bytes as lower case hex digits
+ *
+ * @param[out] hex The output buffer, not NUL terminated
+ * @param[in] hex_len The size of the output buffer
+ * @param[in] bin The input bytes
+ * @param[in] bin_len The number of input bytes
+ * @return int The number of characters written, -1 if the buffer is too small
+ */
+int hex_encode(char *hex, size_t hex_len, uint8_t const *bin, size_t bin_len);
+
+/**
+ * @brief Decode hex digits of either case into bytes
+ *
+ * @param[out] bin The output buffer
+ * @param[in] bin_len The size of the output buffer
+ * @param[in] hex The input characters
+ * @param[in] hex_len The number of input characters
+ * @return int The number of bytes written, -1 if the input has an odd length
+ * or a character which is not a hex digit, or the buffer is too small
+ */
+int hex_decode(uint8_t *bin, size_t bin_len, char const *hex, size_t hex_len);
+
+char const *hex_kernel(); // name of the kernel in use
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
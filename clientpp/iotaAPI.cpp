@@ -7,22 +7,12 @@
  */
 
 #include "iotaAPI.h"
+#include "hexCodec.h"
+#include "jsonUtils.h"
 
 #define JSON_KEY_DATA "data"
 #define JSON_KEY_TIP_MSG_IDS "tipMessageIds"
 
-std::string string_to_hex(const std::string &input) {
-  static const char hex_digits[] = "0123456789ABCDEF";
-
-  std::string output;
-  output.reserve(input.length() * 2);
-  for (unsigned char c : input) {
-    output.push_back(hex_digits[c >> 4]);
-    output.push_back(hex_digits[c & 15]);
-  }
-  return output;
-}
-
 int iotaAPI::getNodeInfo() {
   // get node info
   if (_http.get("/api/v1/info") > 0) {
@@ -33,42 +23,138 @@ int iotaAPI::getNodeInfo() {
   }
 }
 
-int iotaAPI::getTips(std::vector<std::string> &tips) {
-  // get tips
-  if (_http.get("/api/v1/tips") > 0) {
-    // printf("%s\n", _http.response_data().c_str());
-    cJSON *obj = cJSON_Parse(_http.response_data().c_str());
-    cJSON *data_obj = cJSON_GetObjectItemCaseSensitive(obj, JSON_KEY_DATA);
-    if (data_obj) {
-      _json.getArrayString(data_obj, JSON_KEY_TIP_MSG_IDS, tips);
-    } else {
-      cJSON_Delete(obj);
-      return -1;
+// incremental scanner for the string array of the tips response
+/*
+{"data":{"maxResults":...,"tipMessageIds":["7dab...","9f50..."]}}
+*/
+static int tips_sink(void *ctx, char const *at, size_t length) {
+  tips_scanner_t *sc = static_cast<tips_scanner_t *>(ctx);
+  for (size_t i = 0; i < length; i++) {
+    char c = at[i];
+    if (sc->in_string) {
+      if (sc->escaped) {
+        sc->escaped = false;
+      } else if (c == '\\') {
+        sc->escaped = true;
+        continue;
+      } else if (c == '"') {
+        sc->in_string = false;
+        if (sc->in_array) {
+          if (sc->token_len >= TIPS_TOKEN_LEN) {
+            printf("[%s:%d] tip ID too long\n", __func__, __LINE__);
+            return -1;
+          }
+          sc->tips->push_back(std::string(sc->token, sc->token_len));
+        } else {
+          sc->after_key =
+              sc->token_len == strlen(JSON_KEY_TIP_MSG_IDS) &&
+              memcmp(sc->token, JSON_KEY_TIP_MSG_IDS, sc->token_len) == 0;
+        }
+        continue;
+      }
+      if (sc->token_len < TIPS_TOKEN_LEN) {
+        sc->token[sc->token_len] = c;
+      }
+      sc->token_len++;
+      continue;
     }
-    cJSON_Delete(obj);
+
+    switch (c) {
+    case '"':
+      sc->in_string = true;
+      sc->token_len = 0;
+      break;
+    case '[':
+      sc->in_array = sc->after_key;
+      sc->found |= sc->after_key;
+      break;
+    case ']':
+      sc->in_array = false;
+      sc->after_key = false;
+      break;
+    case '{':
+    case '}':
+    case ',':
+      if (!sc->in_array) {
+        sc->after_key = false;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return 0;
+}
+
+iotaAPI::iotaAPI()
+    : _msg_len(0), _pow(POW_THREADS_MAX), _local_pow(IOTA_LOCAL_POW),
+      _pow_params(false), _network_id(0), _min_pow_score(0), _queue(NULL),
+      _refresh_event(0), _refresh_interval(TIPS_REFRESH_INTERVAL),
+      _tips_valid(false), _send_pending(false), _async_busy(false) {
+  memset(&_tips_stats, 0, sizeof(_tips_stats));
+  _submit_mode = IOTA_SUBMIT_MODE;
+  _msg_buf = new uint8_t[MESSAGE_BUF_SIZE];
+}
+
+iotaAPI::~iotaAPI() {
+  if (_queue && _refresh_event) {
+    _queue->cancel(_refresh_event);
+  }
+  _pow.cancel();
+  delete[] _msg_buf;
+}
+
+int iotaAPI::getTips(std::vector<std::string> &tips) {
+  // get tips, parsed while the body is received
+  tips_scanner_t scanner = {};
+  tips.clear();
+  scanner.tips = &tips;
+  if (_http.get("/api/v1/tips", tips_sink, &scanner) > 0 &&
+      _http.response_status_code() == 200 && scanner.found &&
+      !scanner.in_array) {
+    storeTips(tips);
     return 0;
   } else {
     return -1;
   }
 }
 
-int iotaAPI::sendIndexation(const std::string &index, const std::string &data,
-                            std::string &msg_id) {
-  int ret = 0;
+void iotaAPI::storeTips(const std::vector<std::string> &tips) {
+  _tips = tips;
+  _tips_at = Kernel::Clock::now();
+  _tips_valid = true;
+}
 
-  // get tips
-  vector<string> tips;
-  if ((ret = getTips(tips)) != 0) {
-    printf("get tips failed\n");
-    return -1;
+bool iotaAPI::freshTips() {
+  return _tips_valid &&
+         Kernel::Clock::now() - _tips_at < chrono::milliseconds(TIPS_MAX_AGE);
+}
+
+uint32_t iotaAPI::tipsAge() {
+  if (!_tips_valid) {
+    return UINT32_MAX;
   }
+  return chrono::duration_cast<chrono::milliseconds>(Kernel::Clock::now() -
+                                                     _tips_at)
+      .count();
+}
 
-  // compose indexaction data in JSON
-  cJSON *json_msg = cJSON_CreateObject();
-  if (!json_msg) {
-    printf("creating root json failed\n");
-    return -1;
+int iotaAPI::cachedTips(std::vector<std::string> &tips) {
+  if (freshTips()) {
+    _tips_stats.hits++;
+    tips = _tips;
+    return 0;
   }
+  _tips_stats.misses++;
+  return getTips(tips);
+}
+
+int iotaAPI::composeIndexation(const std::string &index,
+                                const std::string &data,
+                                const std::vector<std::string> &tips,
+                                char *buf, size_t buf_len) {
+  json_writer_t w;
+  json_writer_init(&w, buf, buf_len);
 
   // message object
   /*
@@ -84,34 +170,368 @@ int iotaAPI::sendIndexation(const std::string &index, const std::string &data,
   "nonce": ""
   }
   */
-  cJSON_AddStringToObject(json_msg, "networkId", "");
-  _json.arrayString2JSON(tips, json_msg, "parentMessageIds");
+  json_begin_object(&w);
+  // fields left out are filled in by the node
+  if (_submit_mode != IOTA_SUBMIT_MINIMAL) {
+    json_write_key(&w, "networkId");
+    json_write_string(&w, "", 0);
+  }
+  if (_submit_mode == IOTA_SUBMIT_TIPS) {
+    json_write_key(&w, "parentMessageIds");
+    json_begin_array(&w);
+    size_t parent_count = 0;
+    for (const std::string &tip : tips) {
+      if (parent_count == IOTA_MAX_PARENTS) {
+        break;
+      }
+      json_write_string(&w, tip.data(), tip.length());
+      parent_count++;
+    }
+    json_end_array(&w);
+  }
 
   // indexation payload
   /*
   "payload": {
       "type": 2,
-      "index": "696F74612E63",
+      "index": "696f74612e63",
       "data": "426172"
   }
   */
-  cJSON *j_payload = cJSON_CreateObject();
-  cJSON_AddNumberToObject(j_payload, "type", 2);
-  string hex_index = string_to_hex(index);
-  cJSON_AddStringToObject(j_payload, "index", hex_index.c_str());
-  string hex_data = string_to_hex(data);
-  cJSON_AddStringToObject(j_payload, "data", hex_data.c_str());
-  cJSON_AddItemToObject(json_msg, "payload", j_payload);
-
-  cJSON_AddStringToObject(json_msg, "nonce", "");
-
-  string j_str = cJSON_PrintUnformatted(json_msg);
-  // printf("%s\n", j_str.c_str());
+  json_write_key(&w, "payload");
+  json_begin_object(&w);
+  json_write_key(&w, "type");
+  json_write_uint(&w, IOTA_PAYLOAD_INDEXATION);
+  json_write_key(&w, "index");
+  json_write_hex(&w, (uint8_t const *)index.data(), index.length());
+  json_write_key(&w, "data");
+  json_write_hex(&w, (uint8_t const *)data.data(), data.length());
+  json_end_object(&w);
+
+  if (_submit_mode != IOTA_SUBMIT_MINIMAL) {
+    json_write_key(&w, "nonce");
+    json_write_string(&w, "", 0);
+  }
+  json_end_object(&w);
+
+  int len = json_writer_finish(&w);
+  if (len < 0) {
+    printf("[%s:%d] message does not fit into %u bytes\n", __func__,
+           __LINE__, (unsigned)buf_len);
+  }
+  return len;
+}
+
+int iotaAPI::serializeIndexation(const std::string &index,
+                                  const std::string &data,
+                                  const std::vector<std::string> &tips,
+                                  uint8_t *buf, size_t buf_len) {
+  uint8_t parents[IOTA_MAX_PARENTS * IOTA_MESSAGE_ID_BYTES];
+  size_t parent_count = 0;
+  if (_submit_mode == IOTA_SUBMIT_TIPS) {
+    for (const std::string &tip : tips) {
+      if (parent_count == IOTA_MAX_PARENTS) {
+        break;
+      }
+      if (hex_decode(parents + parent_count * IOTA_MESSAGE_ID_BYTES,
+                     IOTA_MESSAGE_ID_BYTES, tip.data(),
+                     tip.length()) != IOTA_MESSAGE_ID_BYTES) {
+        printf("[%s:%d] invalid tip %s\n", __func__, __LINE__, tip.c_str());
+        return -1;
+      }
+      parent_count++;
+    }
+  }
+
+  // network ID and nonce are filled in by the node unless the PoW is local
+  iota_indexation_msg_t msg = {localPow() ? _network_id : 0,
+                               parents,
+                               parent_count,
+                               (uint8_t const *)index.data(),
+                               index.length(),
+                               (uint8_t const *)data.data(),
+                               data.length(),
+                               0};
+  int len = iota_write_indexation(&msg, buf, buf_len);
+  if (len < 0) {
+    printf("[%s:%d] message does not fit into %u bytes\n", __func__,
+           __LINE__, (unsigned)buf_len);
+  }
+  return len;
+}
+
+int iotaAPI::composeMessage(const std::string &index, const std::string &data,
+                            const std::vector<std::string> &tips) {
+  // binary only for complete messages, the node fills in missing fields of
+  // JSON messages
+  if (localPow()) {
+    return serializeIndexation(index, data, tips, _msg_buf, MESSAGE_BUF_SIZE);
+  }
+  return composeIndexation(index, data, tips, (char *)_msg_buf,
+                           MESSAGE_BUF_SIZE);
+}
+
+bool iotaAPI::localPow() {
+  return _local_pow && _submit_mode == IOTA_SUBMIT_TIPS;
+}
+
+// node info
+/*
+{"data":{"name":"HORNET",...,"networkId":"14379272398717627559",
+"minPoWScore":4000,...}}
+*/
+int iotaAPI::parsePowParams(const std::string &info) {
+  jsonUtils json;
+  std::string network_id;
+  int min_score = 0;
+  int ret = -1;
+
+  cJSON *obj = cJSON_Parse(info.c_str());
+  cJSON *data = cJSON_GetObjectItemCaseSensitive(obj, JSON_KEY_DATA);
+  if (json.getString(data, "networkId", network_id) == 0 &&
+      json.getInt(data, "minPoWScore", &min_score) == 0 && min_score > 0) {
+    _network_id = strtoull(network_id.c_str(), NULL, 10);
+    _min_pow_score = min_score;
+    _pow_params = true;
+    ret = 0;
+  } else {
+    printf("[%s:%d] no PoW parameters in node info\n", __func__, __LINE__);
+  }
+  cJSON_Delete(obj);
+  return ret;
+}
+
+int iotaAPI::getPowParams() {
+  if (_pow_params) {
+    return 0;
+  }
+  if (_http.get("/api/v1/info") <= 0 || _http.response_status_code() != 200) {
+    return -1;
+  }
+  return parsePowParams(_http.response_data());
+}
+
+char const *iotaAPI::messageType() {
+  return localPow() ? "application/octet-stream" : "application/json";
+}
+
+int iotaAPI::sendIndexation(const std::string &index, const std::string &data,
+                            std::string &msg_id) {
+  int ret = 0;
+
+  // get tips, from the cache unless they are too old
+  vector<string> tips;
+  if (_submit_mode == IOTA_SUBMIT_TIPS && (ret = cachedTips(tips)) != 0) {
+    printf("get tips failed\n");
+    return -1;
+  }
+
+  if (localPow() && getPowParams() != 0) {
+    printf("get node info failed\n");
+    return -1;
+  }
+  int len = composeMessage(index, data, tips);
+  if (len < 0) {
+    return -1;
+  }
+  if (localPow() && _pow.solve(_msg_buf, len, _min_pow_score) != 0) {
+    return -1;
+  }
   // send to node
-  ret = _http.post("/api/v1/messages", j_str);
+  ret = _http.post("/api/v1/messages", (char const *)_msg_buf, len,
+                   messageType());
   if (ret > 0) {
     printf("%s\n", _http.response_data().c_str());
   }
-  cJSON_Delete(json_msg);
+  // failed requests were retried by the client already
+  return ret > 0 && _http.response_status_code() / 100 == 2 ? 0 : -1;
+}
+
+void iotaAPI::setEventQueue(EventQueue *queue) {
+  if (_queue && _refresh_event) {
+    _queue->cancel(_refresh_event);
+    _refresh_event = 0;
+  }
+  _queue = queue;
+  _http.set_event_queue(queue);
+  if (_queue && _refresh_interval > 0) {
+    // keep the tips fresh so that sending takes a single request
+    _refresh_event =
+        _queue->call_every(chrono::milliseconds(_refresh_interval),
+                           callback(this, &iotaAPI::refreshTips));
+  }
+}
+
+void iotaAPI::setSubmitMode(iota_submit_mode_t mode) { _submit_mode = mode; }
+
+void iotaAPI::setTipsRefreshInterval(uint32_t ms) { _refresh_interval = ms; }
+
+void iotaAPI::setLocalPow(bool enable) { _local_pow = enable; }
+
+int iotaAPI::addNode(const char *host, uint16_t port) {
+  return _http.add_node(host, port);
+}
+
+int iotaAPI::fetchTipsAsync(http_done_cb_t done) {
+  _async_tips.clear();
+  _async_scanner = {};
+  _async_scanner.tips = &_async_tips;
+  return _http.get_async("/api/v1/tips", done, tips_sink, &_async_scanner);
+}
+
+bool iotaAPI::fetchedTips(httpClient *client, int ret) {
+  if (ret <= 0 || client->response_status_code() != 200 ||
+      !_async_scanner.found || _async_scanner.in_array) {
+    return false;
+  }
+  storeTips(_async_tips);
+  return true;
+}
+
+int iotaAPI::sendIndexationAsync(const std::string &index,
+                                 const std::string &data,
+                                 mbed::Callback<void(int)> done) {
+  if (!_queue || _async_busy) {
+    return -1;
+  }
+  _async_busy = true;
+  _async_index = index;
+  _async_data = data;
+  _async_done = done;
+  // the client is only used from the event queue thread
+  if (_queue->call(callback(this, &iotaAPI::startIndexation)) == 0) {
+    _async_busy = false;
+    return -1;
+  }
   return 0;
-}
\ No newline at end of file
+}
+
+void iotaAPI::startIndexation() {
+  if (_http.busy()) {
+    // a tip refresh is in flight, carry on when it is done
+    _send_pending = true;
+    return;
+  }
+  if (_submit_mode != IOTA_SUBMIT_TIPS) {
+    // the node attaches the message
+    postIndexation(vector<string>());
+    return;
+  }
+  if (localPow() && !_pow_params) {
+    if (_http.get_async("/api/v1/info", callback(this, &iotaAPI::onNodeInfo)) !=
+        0) {
+      asyncDone(-1);
+    }
+    return;
+  }
+  if (freshTips()) {
+    _tips_stats.hits++;
+    postIndexation(_tips);
+    return;
+  }
+  _tips_stats.misses++;
+  if (fetchTipsAsync(callback(this, &iotaAPI::onTips)) != 0) {
+    asyncDone(-1);
+  }
+}
+
+void iotaAPI::postIndexation(const std::vector<std::string> &tips) {
+  // the message buffer stays untouched until onMessage()
+  _msg_len = composeMessage(_async_index, _async_data, tips);
+  if (_msg_len < 0) {
+    asyncDone(-1);
+    return;
+  }
+  if (localPow()) {
+    // searched in slices, other events run in between
+    _pow.prepare(_msg_buf, _msg_len, _min_pow_score);
+    powStep();
+    return;
+  }
+  if (_http.post_async("/api/v1/messages", (char const *)_msg_buf, _msg_len,
+                       messageType(), callback(this, &iotaAPI::onMessage)) !=
+      0) {
+    asyncDone(-1);
+  }
+}
+
+void iotaAPI::powStep() {
+  int ret = _pow.search(POW_SLICE);
+  if (ret == 0) {
+    if (_queue->call(callback(this, &iotaAPI::powStep)) == 0) {
+      asyncDone(-1);
+    }
+    return;
+  }
+  if (ret < 0) {
+    printf("PoW cancelled\n");
+    asyncDone(-1);
+    return;
+  }
+  powEngine::putNonce(_msg_buf, _msg_len, _pow.nonce());
+  if (_http.post_async("/api/v1/messages", (char const *)_msg_buf, _msg_len,
+                       messageType(), callback(this, &iotaAPI::onMessage)) !=
+      0) {
+    asyncDone(-1);
+  }
+}
+
+void iotaAPI::onNodeInfo(httpClient *client, int ret) {
+  if (ret <= 0 || client->response_status_code() != 200 ||
+      parsePowParams(client->response_data()) != 0) {
+    printf("get node info failed\n");
+    asyncDone(-1);
+    return;
+  }
+  startIndexation();
+}
+
+void iotaAPI::onTips(httpClient *client, int ret) {
+  if (!fetchedTips(client, ret)) {
+    printf("get tips failed\n");
+    asyncDone(-1);
+    return;
+  }
+  postIndexation(_tips);
+}
+
+void iotaAPI::onMessage(httpClient *client, int ret) {
+  if (ret > 0) {
+    printf("%s\n", client->response_data().c_str());
+  }
+  asyncDone(ret > 0 && client->response_status_code() / 100 == 2 ? 0 : -1);
+}
+
+void iotaAPI::refreshTips() {
+  // skip the round if the client is busy or the tips were just fetched, and
+  // while a message is on its way, the local PoW leaves the client idle
+  // between slices and posts the message when it is done
+  if (_submit_mode != IOTA_SUBMIT_TIPS || _async_busy || _http.busy() ||
+      (_tips_valid && tipsAge() < _refresh_interval / 2)) {
+    return;
+  }
+  if (fetchTipsAsync(callback(this, &iotaAPI::onTipsRefreshed)) != 0) {
+    _tips_stats.refresh_failures++;
+  }
+}
+
+void iotaAPI::onTipsRefreshed(httpClient *client, int ret) {
+  if (fetchedTips(client, ret)) {
+    _tips_stats.refreshes++;
+  } else {
+    _tips_stats.refresh_failures++;
+  }
+  if (_send_pending) {
+    _send_pending = false;
+    startIndexation();
+  }
+}
+
+void iotaAPI::asyncDone(int ret) {
+  // the next message may be queued from within the callback
+  mbed::Callback<void(int)> done = _async_done;
+  _async_busy = false;
+  if (done) {
+    done(ret);
+  }
+}
@@ -10,21 +10,142 @@
 #define __IOTA_CLIENT_H__
 
 #include "httpClient/httpClient.h"
-#include "jsonUtils.h"
+#include "jsonWriter.h"
 #include "main_config.h"
+#include "messageWriter.h"
+#include "powEngine.h"
 #include <string>
 #include <vector>
 
+#define TIPS_TOKEN_LEN 72 // longer than a hex encoded message ID
+
+// incremental scanner state for the tips response
+typedef struct {
+  std::vector<std::string> *tips;
+  char token[TIPS_TOKEN_LEN];
+  size_t token_len;
+  bool in_string;
+  bool escaped;
+  bool after_key; // the last string was the array key
+  bool in_array;
+  bool found;
+} tips_scanner_t;
+
+typedef struct {
+  uint32_t hits;             // messages sent with cached tips
+  uint32_t misses;           // messages which had to fetch tips first
+  uint32_t refreshes;        // background refreshes
+  uint32_t refresh_failures; // background refreshes which failed
+} tips_stats_t;
+
+// how much of a message is left to the node
+typedef enum {
+  IOTA_SUBMIT_TIPS = 0,     // parents from the tips API
+  IOTA_SUBMIT_NODE_PARENTS, // the node selects the parents
+  IOTA_SUBMIT_MINIMAL,      // the node also fills in networkId and nonce
+} iota_submit_mode_t;
+
 class iotaAPI {
 public:
+  iotaAPI();
+  ~iotaAPI();
+
   int getNodeInfo();
   int sendIndexation(const std::string &index, const std::string &data,
                      std::string &msg_id);
-  int getTips(std::vector<std::string> &tips);
+  int getTips(std::vector<std::string> &tips); // also updates the tip cache
+
+  /**
+   * @brief Send an indexation message without blocking the caller
+   *
+   * Runs on the event queue given to setEventQueue(). With fresh tips in the
+   * cache the message is posted right away, otherwise tips are fetched first.
+   *
+   * @param[in] index The index of the message
+   * @param[in] data The message data
+   * @param[in] done Called on the event queue with 0 on success, -1 otherwise
+   * @return int 0 if the message was queued, -1 if the previous one is still
+   * in progress
+   */
+  int sendIndexationAsync(const std::string &index, const std::string &data,
+                          mbed::Callback<void(int)> done);
+  // also refreshes the tip cache every TIPS_REFRESH_INTERVAL on the queue,
+  // the client must then only be used through the asynchronous calls
+  void setEventQueue(EventQueue *queue);
+  // in ms, 0 disables the refresh, takes effect with the next setEventQueue()
+  void setTipsRefreshInterval(uint32_t ms);
+  // add a node to fail over to, requests go to the fastest healthy node
+  int addNode(const char *host, uint16_t port);
+  void setSubmitMode(iota_submit_mode_t mode);
+  // compute the nonce locally, only in IOTA_SUBMIT_TIPS mode where the node
+  // does not change the message, which is then sent in binary. Messages the
+  // node completes are sent as JSON.
+  void setLocalPow(bool enable);
+  const tips_stats_t &tipsStats() { return _tips_stats; }
+  const http_stats_t &httpStats() { return _http.stats(); }
+  uint32_t tipsAge(); // in ms, UINT32_MAX if there are no tips
+
+  // the message encodings, parents are left out unless the mode is
+  // IOTA_SUBMIT_TIPS, both return the message length or -1 if it does not fit
+  int composeIndexation(const std::string &index, const std::string &data,
+                        const std::vector<std::string> &tips, char *buf,
+                        size_t buf_len);
+  int serializeIndexation(const std::string &index, const std::string &data,
+                          const std::vector<std::string> &tips, uint8_t *buf,
+                          size_t buf_len);
 
 private:
+  // encodes into the message buffer, returns the body length
+  int composeMessage(const std::string &index, const std::string &data,
+                     const std::vector<std::string> &tips);
+  char const *messageType();
+  bool localPow();
+  int getPowParams(); // network ID and minimum score from the node info
+  int parsePowParams(const std::string &info);
+  void onNodeInfo(httpClient *client, int ret);
+  void powStep();
+  void storeTips(const std::vector<std::string> &tips);
+  bool freshTips(); // younger than TIPS_MAX_AGE
+  int cachedTips(std::vector<std::string> &tips);
+  int fetchTipsAsync(http_done_cb_t done);
+  bool fetchedTips(httpClient *client, int ret);
+  void startIndexation();
+  void postIndexation(const std::vector<std::string> &tips);
+  void onTips(httpClient *client, int ret);
+  void onMessage(httpClient *client, int ret);
+  void refreshTips();
+  void onTipsRefreshed(httpClient *client, int ret);
+  void asyncDone(int ret);
+
   httpClient _http;
-  jsonUtils _json;
+  iota_submit_mode_t _submit_mode;
+  uint8_t *_msg_buf; // the encoded message, allocated once
+  int _msg_len;
+
+  // local proof of work
+  powEngine _pow;
+  bool _local_pow;
+  bool _pow_params; // fetched from the node
+  uint64_t _network_id;
+  uint32_t _min_pow_score;
+  EventQueue *_queue;
+  int _refresh_event;
+  uint32_t _refresh_interval;
+
+  // tip cache
+  std::vector<std::string> _tips;
+  Kernel::Clock::time_point _tips_at;
+  bool _tips_valid;
+  tips_stats_t _tips_stats;
+
+  // asynchronous indexation
+  std::string _async_index;
+  std::string _async_data;
+  std::vector<std::string> _async_tips;
+  tips_scanner_t _async_scanner;
+  mbed::Callback<void(int)> _async_done;
+  bool _send_pending; // waits for a tip refresh to complete
+  volatile bool _async_busy;
 };
 
 #endif
\ No newline at end of file
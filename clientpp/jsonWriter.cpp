@@ -0,0 +1,137 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Streaming JSON writer
+ *
+ */
+
+#include <string.h>
+
+#include "hexCodec.h"
+#include "jsonWriter.h"
+
+static char *reserve(json_writer_t *w, size_t n) {
+  if (w->overflow || w->pos + n > w->len) {
+    w->overflow = true;
+    return NULL;
+  }
+  char *p = w->buf + w->pos;
+  w->pos += n;
+  return p;
+}
+
+static void put_char(json_writer_t *w, char c) {
+  char *p = reserve(w, 1);
+  if (p) {
+    *p = c;
+  }
+}
+
+static void put_mem(json_writer_t *w, char const *s, size_t n) {
+  char *p = reserve(w, n);
+  if (p) {
+    memcpy(p, s, n);
+  }
+}
+
+// starts an element of the enclosing object or array
+static void element(json_writer_t *w) {
+  if (w->comma) {
+    put_char(w, ',');
+  }
+  w->comma = true;
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t buf_len) {
+  w->buf = buf;
+  w->len = buf_len;
+  w->pos = 0;
+  w->overflow = false;
+  w->comma = false;
+}
+
+void json_write_key(json_writer_t *w, char const *key) {
+  json_write_string(w, key, strlen(key));
+  put_char(w, ':');
+  w->comma = false;
+}
+
+void json_begin_object(json_writer_t *w) {
+  element(w);
+  put_char(w, '{');
+  w->comma = false;
+}
+
+void json_end_object(json_writer_t *w) {
+  put_char(w, '}');
+  w->comma = true;
+}
+
+void json_begin_array(json_writer_t *w) {
+  element(w);
+  put_char(w, '[');
+  w->comma = false;
+}
+
+void json_end_array(json_writer_t *w) {
+  put_char(w, ']');
+  w->comma = true;
+}
+
+void json_write_string(json_writer_t *w, char const *str, size_t len) {
+  static const char hex_digits[] = "0123456789abcdef";
+  element(w);
+  put_char(w, '"');
+  size_t start = 0;
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = str[i];
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    // copy the plain run before the escaped character
+    put_mem(w, str + start, i - start);
+    start = i + 1;
+    if (c == '"' || c == '\\') {
+      char esc[2] = {'\\', (char)c};
+      put_mem(w, esc, 2);
+    } else {
+      char esc[6] = {'\\', 'u', '0', '0', hex_digits[c >> 4],
+                     hex_digits[c & 15]};
+      put_mem(w, esc, 6);
+    }
+  }
+  put_mem(w, str + start, len - start);
+  put_char(w, '"');
+}
+
+void json_write_hex(json_writer_t *w, uint8_t const *data, size_t len) {
+  element(w);
+  put_char(w, '"');
+  char *p = reserve(w, len * 2);
+  if (p) {
+    hex_encode(p, len * 2, data, len);
+  }
+  put_char(w, '"');
+}
+
+void json_write_uint(json_writer_t *w, uint64_t v) {
+  char digits[20];
+  size_t n = 0;
+  element(w);
+  do {
+    digits[n++] = '0' + (v % 10);
+    v /= 10;
+  } while (v);
+  char *p = reserve(w, n);
+  if (p) {
+    while (n) {
+      *p++ = digits[--n];
+    }
+  }
+}
+
+int json_writer_finish(json_writer_t *w) {
+  return w->overflow ? -1 : (int)w->pos;
+}
@@ -0,0 +1,55 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Streaming JSON writer
+ *
+ * Emits compact JSON into a caller buffer as it is written, without building
+ * a tree and without heap allocation. Commas are inserted by the writer. It
+ * has no Mbed OS dependency and builds on a host as well.
+ */
+
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t pos;
+  bool overflow;
+  bool comma; // the next element needs a separator
+} json_writer_t;
+
+void json_writer_init(json_writer_t *w, char *buf, size_t buf_len);
+
+// a key is followed by exactly one value, object or array
+void json_write_key(json_writer_t *w, char const *key);
+void json_begin_object(json_writer_t *w);
+void json_end_object(json_writer_t *w);
+void json_begin_array(json_writer_t *w);
+void json_end_array(json_writer_t *w);
+void json_write_string(json_writer_t *w, char const *str, size_t len);
+void json_write_hex(json_writer_t *w, uint8_t const *data, size_t len);
+void json_write_uint(json_writer_t *w, uint64_t v);
+
+/**
+ * @brief Complete the output
+ *
+ * @return int The length written, -1 if the buffer was too small
+ */
+int json_writer_finish(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
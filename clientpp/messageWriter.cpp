@@ -0,0 +1,128 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Binary serializer of indexation messages
+ *
+ */
+
+#include <string.h>
+
+#include "blake2b-mb.h"
+#include "messageWriter.h"
+
+// message
+/*
+networkId u64 | parentsCount u8 | parents 32B each | payloadLength u32 |
+payload | nonce u64
+*/
+// indexation payload
+/*
+type u32 | index length u16 | index | data length u32 | data
+*/
+#define PAYLOAD_HEAD_LEN (4 + 2 + 4)
+#define MESSAGE_HEAD_LEN (8 + 1)
+#define MESSAGE_TAIL_LEN (4 + 8)
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+  return p + 4;
+}
+
+static uint8_t *put_u64(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = (v >> (8 * i)) & 0xff;
+  }
+  return p + 8;
+}
+
+// insertion sort straight into the output, returns the number of parents
+static size_t put_parents(uint8_t *p, uint8_t const *parents, size_t count) {
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t const *id = parents + i * IOTA_MESSAGE_ID_BYTES;
+    size_t pos = n;
+    int cmp = 1;
+    while (pos > 0 && (cmp = memcmp(p + (pos - 1) * IOTA_MESSAGE_ID_BYTES, id,
+                                    IOTA_MESSAGE_ID_BYTES)) > 0) {
+      pos--;
+    }
+    if (pos > 0 && cmp == 0) {
+      continue; // duplicate
+    }
+    memmove(p + (pos + 1) * IOTA_MESSAGE_ID_BYTES,
+            p + pos * IOTA_MESSAGE_ID_BYTES, (n - pos) * IOTA_MESSAGE_ID_BYTES);
+    memcpy(p + pos * IOTA_MESSAGE_ID_BYTES, id, IOTA_MESSAGE_ID_BYTES);
+    n++;
+  }
+  return n;
+}
+
+size_t iota_indexation_len(iota_indexation_msg_t const *msg) {
+  return MESSAGE_HEAD_LEN + msg->parent_count * IOTA_MESSAGE_ID_BYTES +
+         MESSAGE_TAIL_LEN + PAYLOAD_HEAD_LEN + msg->index_len + msg->data_len;
+}
+
+int iota_write_indexation(iota_indexation_msg_t const *msg, uint8_t *buf,
+                          size_t buf_len) {
+  if (msg->parent_count > IOTA_MAX_PARENTS || msg->index_len == 0 ||
+      msg->index_len > IOTA_INDEX_MAX_BYTES) {
+    return -1;
+  }
+  if (iota_indexation_len(msg) > buf_len) {
+    return -1;
+  }
+
+  uint8_t *p = put_u64(buf, msg->network_id);
+  uint8_t *count = p++;
+  size_t parents = put_parents(p, msg->parents, msg->parent_count);
+  *count = (uint8_t)parents;
+  p += parents * IOTA_MESSAGE_ID_BYTES;
+
+  p = put_u32(p, PAYLOAD_HEAD_LEN + msg->index_len + msg->data_len);
+  p = put_u32(p, IOTA_PAYLOAD_INDEXATION);
+  p = put_u16(p, (uint16_t)msg->index_len);
+  memcpy(p, msg->index, msg->index_len);
+  p += msg->index_len;
+  p = put_u32(p, (uint32_t)msg->data_len);
+  if (msg->data_len) {
+    memcpy(p, msg->data, msg->data_len);
+    p += msg->data_len;
+  }
+  p = put_u64(p, msg->nonce);
+  return (int)(p - buf);
+}
+
+int iota_message_ids(uint8_t const *const *msgs, size_t const *lens,
+                     size_t count, uint8_t *ids) {
+  if (!msgs || !lens || !ids) {
+    return -1;
+  }
+
+  // a few lane groups at a time
+  blake2b_job jobs[2 * BLAKE2B_MB_MAX_LANES];
+  const size_t batch = sizeof(jobs) / sizeof(jobs[0]);
+  for (size_t i = 0; i < count; i += batch) {
+    size_t n = count - i < batch ? count - i : batch;
+    for (size_t j = 0; j < n; j++) {
+      jobs[j].out = ids + (i + j) * IOTA_MESSAGE_ID_BYTES;
+      jobs[j].outlen = IOTA_MESSAGE_ID_BYTES;
+      jobs[j].in = msgs[i + j];
+      jobs[j].inlen = lens[i + j];
+      jobs[j].param = NULL;
+    }
+    if (blake2b_many(jobs, n) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Binary serializer of indexation messages
+ *
+ * Writes a message in the node's binary format into a caller buffer without
+ * heap allocation. Fields left zero or empty are filled in by the node. It
+ * has no Mbed OS dependency and builds on a host as well.
+ */
+
+#ifndef __MESSAGE_WRITER_H__
+#define __MESSAGE_WRITER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IOTA_MESSAGE_ID_BYTES 32
+#define IOTA_MAX_PARENTS 8
+#define IOTA_INDEX_MAX_BYTES 64
+#define IOTA_PAYLOAD_INDEXATION 2
+
+typedef struct {
+  uint64_t network_id;    // 0 for the node's network
+  uint8_t const *parents; // parent_count message IDs, in any order
+  size_t parent_count;    // 0 for parents selected by the node
+  uint8_t const *index;
+  size_t index_len;
+  uint8_t const *data;
+  size_t data_len;
+  uint64_t nonce; // 0 for proof of work done by the node
+} iota_indexation_msg_t;
+
+/**
+ * @brief Serialize an indexation message
+ *
+ * Parents are written in lexicographic order with duplicates removed, as the
+ * node requires.
+ *
+ * @param[in] msg The message
+ * @param[out] buf The output buffer
+ * @param[in] buf_len The size of the buffer
+ * @return int The length of the message, -1 if the buffer is too small or a
+ * field is out of range
+ */
+int iota_write_indexation(iota_indexation_msg_t const *msg, uint8_t *buf,
+                          size_t buf_len);
+
+/**
+ * @brief The serialized length of an indexation message
+ *
+ * @return size_t The length with all parents, an upper bound if some of them
+ * are duplicates
+ */
+size_t iota_indexation_len(iota_indexation_msg_t const *msg);
+
+/**
+ * @brief Compute the IDs of serialized messages
+ *
+ * A message ID is the BLAKE2b-256 hash of the whole message, nonce included.
+ * The messages are hashed side by side when the CPU has SIMD lanes for it.
+ *
+ * @param[in] msgs The serialized messages
+ * @param[in] lens The lengths of the messages
+ * @param[in] count The number of messages
+ * @param[out] ids count IDs of IOTA_MESSAGE_ID_BYTES each
+ * @return int 0 on success, -1 on invalid parameters
+ */
+int iota_message_ids(uint8_t const *const *msgs, size_t const *lens,
+                     size_t count, uint8_t *ids);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
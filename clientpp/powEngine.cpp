@@ -0,0 +1,282 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Local proof of work for message nonces
+ *
+ */
+
+#include <string.h>
+
+#include "blake2.h"
+#include "powEngine.h"
+
+#if POW_THREADS
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+#define CURL_STATE 729
+#define CURL_HASH 243
+#define CURL_ROUNDS 81
+#define NONCE_TRITS (POW_NONCE_BYTES * 6)
+
+// bitsliced trits, one bit per lane: -1 is (1, 0), 0 is (1, 1), 1 is (0, 1)
+#define LANES_ALL ((pow_lane_t)~(pow_lane_t)0)
+
+// balanced ternary, least significant trit first
+static void tryte_trits(int t, int8_t *trits) {
+  for (int i = 0; i < 3; i++) {
+    int r = t % 3;
+    t /= 3;
+    if (r > 1) {
+      r -= 3;
+      t++;
+    } else if (r < -1) {
+      r += 3;
+      t--;
+    }
+    trits[i] = r;
+  }
+}
+
+// b1t6, a signed byte as two trytes
+static void b1t6_encode(uint8_t const *bin, size_t len, int8_t *trits) {
+  for (size_t i = 0; i < len; i++) {
+    int v = (int8_t)bin[i] + 13 * 27 + 13;
+    tryte_trits(v % 27 - 13, trits + 6 * i);
+    tryte_trits(v / 27 - 13, trits + 6 * i + 3);
+  }
+}
+
+static void set_trit(pow_lane_t *lo, pow_lane_t *hi, pow_lane_t bit,
+                     int8_t trit) {
+  if (trit > 0) {
+    *lo &= ~bit;
+  } else if (trit < 0) {
+    *hi &= ~bit;
+  }
+}
+
+// the state alternates between the two halves of lo and hi, returns the
+// offset of the result
+static int curl_transform(pow_lane_t *lo, pow_lane_t *hi) {
+  int from = 0, to = CURL_STATE;
+  for (int r = 0; r < CURL_ROUNDS; r++) {
+    pow_lane_t const *flo = lo + from, *fhi = hi + from;
+    pow_lane_t *tlo = lo + to, *thi = hi + to;
+    int t = 0;
+    for (int i = 0; i < CURL_STATE; i++) {
+      pow_lane_t alpha = flo[t];
+      pow_lane_t beta = fhi[t];
+      t += t < 365 ? 364 : -365;
+      pow_lane_t gamma = fhi[t];
+      pow_lane_t delta = (alpha | ~gamma) & (flo[t] ^ beta);
+      tlo[i] = ~delta;
+      thi[i] = (alpha ^ gamma) | delta;
+    }
+    from = to;
+    to = CURL_STATE - to;
+  }
+  return from;
+}
+
+powEngine::powEngine(unsigned threads)
+    : _target(0), _threads(threads), _prepared(false), _nonce(0),
+      _hashes(0), _next(0), _cancelled(false) {
+  // too large for the stack of an event thread
+  _state = new pow_lane_t[POW_STATE_LANES];
+#if POW_THREADS
+  _found = false;
+  if (_threads == 0) {
+    _threads = std::thread::hardware_concurrency();
+  }
+#endif
+  if (_threads == 0) {
+    _threads = 1;
+  }
+}
+
+powEngine::~powEngine() { delete[] _state; }
+
+void powEngine::digestTrits(uint8_t const *msg, size_t len, int8_t *trits) {
+  uint8_t digest[32];
+  blake2b(digest, sizeof(digest), msg, len - POW_NONCE_BYTES, NULL, 0);
+  b1t6_encode(digest, sizeof(digest), trits);
+}
+
+unsigned powEngine::targetZeros(size_t len, uint32_t min_score) {
+  // the smallest n with 3^n / len >= min_score
+  uint64_t needed = (uint64_t)min_score * len;
+  uint64_t v = 1;
+  unsigned n = 0;
+  while (v < needed) {
+    v *= 3;
+    n++;
+  }
+  return n;
+}
+
+int powEngine::hash(int8_t const *digest, uint64_t base, pow_lane_t *state) {
+  pow_lane_t *lo = state, *hi = state + 2 * CURL_STATE;
+  int8_t trits[NONCE_TRITS];
+
+  // the digest is the same in every lane, the rest of the state is zero
+  for (int i = 0; i < CURL_STATE; i++) {
+    lo[i] = LANES_ALL;
+    hi[i] = LANES_ALL;
+  }
+  for (int i = 0; i < POW_DIGEST_TRITS; i++) {
+    set_trit(&lo[i], &hi[i], LANES_ALL, digest[i]);
+  }
+  for (unsigned lane = 0; lane < POW_LANES; lane++) {
+    uint8_t nonce[POW_NONCE_BYTES];
+    uint64_t v = base + lane;
+    for (int i = 0; i < POW_NONCE_BYTES; i++) {
+      nonce[i] = (v >> (8 * i)) & 0xff;
+    }
+    b1t6_encode(nonce, POW_NONCE_BYTES, trits);
+    pow_lane_t bit = (pow_lane_t)1 << lane;
+    for (int i = 0; i < NONCE_TRITS; i++) {
+      set_trit(&lo[POW_DIGEST_TRITS + i], &hi[POW_DIGEST_TRITS + i], bit,
+               trits[i]);
+    }
+  }
+  return curl_transform(lo, hi);
+}
+
+int powEngine::batch(int8_t const *digest, uint64_t base, unsigned target,
+                     pow_lane_t *state) {
+  int offset = hash(digest, base, state);
+  pow_lane_t const *lo = state + offset, *hi = state + 2 * CURL_STATE + offset;
+
+  // lanes whose hash ends with target zero trits
+  pow_lane_t zeros = LANES_ALL;
+  for (unsigned i = CURL_HASH - target; i < CURL_HASH && zeros; i++) {
+    zeros &= lo[i] & hi[i];
+  }
+  if (!zeros) {
+    return -1;
+  }
+  int lane = 0;
+  while (!(zeros & 1)) {
+    zeros >>= 1;
+    lane++;
+  }
+  return lane;
+}
+
+unsigned powEngine::trailingZeros(uint8_t const *msg, size_t len) {
+  if (len < POW_NONCE_BYTES) {
+    return 0;
+  }
+  int8_t digest[POW_DIGEST_TRITS];
+  digestTrits(msg, len, digest);
+  uint64_t nonce = 0;
+  for (int i = 0; i < POW_NONCE_BYTES; i++) {
+    nonce |= (uint64_t)msg[len - POW_NONCE_BYTES + i] << (8 * i);
+  }
+  int offset = hash(digest, nonce, _state);
+  pow_lane_t const *lo = _state + offset;
+  pow_lane_t const *hi = _state + 2 * CURL_STATE + offset;
+  // the message nonce is in lane 0
+  unsigned zeros = 0;
+  while (zeros < CURL_HASH && (lo[CURL_HASH - 1 - zeros] &
+                               hi[CURL_HASH - 1 - zeros] & 1)) {
+    zeros++;
+  }
+  return zeros;
+}
+
+int powEngine::prepare(uint8_t const *msg, size_t len, uint32_t min_score) {
+  if (len <= POW_NONCE_BYTES) {
+    return -1;
+  }
+  digestTrits(msg, len, _digest);
+  _target = targetZeros(len, min_score);
+  _next = 0;
+  _nonce = 0;
+  _hashes = 0;
+  _cancelled = false;
+  _prepared = true;
+  return 0;
+}
+
+int powEngine::search(uint32_t batches) {
+  if (!_prepared || _cancelled) {
+    return -1;
+  }
+  for (uint32_t b = 0; b < batches; b++) {
+    uint64_t base = _next;
+    _next = base + POW_LANES;
+    int lane = batch(_digest, base, _target, _state);
+    if (lane >= 0) {
+      _nonce = base + lane;
+      _hashes += lane + 1;
+      _prepared = false;
+      return 1;
+    }
+    _hashes += POW_LANES;
+  }
+  return 0;
+}
+
+#if POW_THREADS
+void powEngine::worker() {
+  static std::mutex mutex;
+  pow_lane_t state[POW_STATE_LANES];
+  uint64_t hashes = 0;
+  while (!_found && !_cancelled) {
+    uint64_t base = _next.fetch_add(POW_LANES);
+    int lane = batch(_digest, base, _target, state);
+    hashes += POW_LANES;
+    if (lane >= 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      // keep the lowest nonce if several threads hit at once
+      if (!_found || base + lane < _nonce) {
+        _nonce = base + lane;
+      }
+      _found = true;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  _hashes += hashes;
+}
+#endif
+
+int powEngine::solve(uint8_t *msg, size_t len, uint32_t min_score) {
+  if (prepare(msg, len, min_score) != 0) {
+    return -1;
+  }
+  int ret = 0;
+#if POW_THREADS
+  _found = false;
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < _threads; i++) {
+    workers.emplace_back(&powEngine::worker, this);
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  _prepared = false;
+  ret = _found ? 1 : -1;
+#else
+  while ((ret = search(1)) == 0) {
+  }
+#endif
+  if (ret != 1) {
+    return -1;
+  }
+  putNonce(msg, len, _nonce);
+  return 0;
+}
+
+void powEngine::putNonce(uint8_t *msg, size_t len, uint64_t nonce) {
+  for (int i = 0; i < POW_NONCE_BYTES; i++) {
+    msg[len - POW_NONCE_BYTES + i] = (nonce >> (8 * i)) & 0xff;
+  }
+}
+
+void powEngine::cancel() { _cancelled = true; }
@@ -0,0 +1,113 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Local proof of work for message nonces
+ *
+ * Chrysalis PoW: the BLAKE2b-256 digest of the message without its nonce and
+ * the nonce itself are b1t6 encoded into trits and hashed with Curl-P-81. The
+ * score is 3 to the power of the trailing zero trits of the hash divided by
+ * the message length.
+ *
+ * Curl runs bitsliced, one nonce per bit of a machine word. On Linux and
+ * macOS hosts solve() splits the search over all cores. On Mbed OS it runs on
+ * the calling thread, and search() lets the caller work in slices from an
+ * event queue. Both can be stopped with cancel(). It builds on a host as
+ * well.
+ */
+
+#ifndef __POW_ENGINE_H__
+#define __POW_ENGINE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(__MBED__) && (defined(__linux__) || defined(__APPLE__))
+#define POW_THREADS 1
+#include <atomic>
+#else
+#define POW_THREADS 0
+#endif
+
+#define POW_NONCE_BYTES 8 // at the end of a serialized message
+#define POW_DIGEST_TRITS 192
+
+#if UINTPTR_MAX > 0xffffffffu
+typedef uint64_t pow_lane_t;
+#else
+typedef uint32_t pow_lane_t;
+#endif
+#define POW_LANES (sizeof(pow_lane_t) * 8) // nonces per Curl transform
+#define POW_STATE_LANES (4 * 729) // two Curl states of low and high bits
+
+class powEngine {
+public:
+  powEngine(unsigned threads = 0); // 0 for all cores of a host
+  ~powEngine();
+
+  /**
+   * @brief Start a search for a message
+   *
+   * @param[in] msg The serialized message including the nonce field
+   * @param[in] len The message length
+   * @param[in] min_score The minimum PoW score of the network
+   * @return int 0 on success, -1 if the message is too short
+   */
+  int prepare(uint8_t const *msg, size_t len, uint32_t min_score);
+
+  /**
+   * @brief Try the next batches of POW_LANES nonces on the calling thread
+   *
+   * @return int 1 if nonce() meets the score, 0 if not found yet, -1 if not
+   * prepared or cancelled
+   */
+  int search(uint32_t batches);
+
+  /**
+   * @brief Find a nonce and write it into the message
+   *
+   * @return int 0 on success, -1 if cancelled
+   */
+  int solve(uint8_t *msg, size_t len, uint32_t min_score);
+  void cancel(); // from any thread
+  uint64_t nonce() { return _nonce; }
+  static void putNonce(uint8_t *msg, size_t len, uint64_t nonce);
+  uint64_t hashes() { return _hashes; } // tried by the last search
+  unsigned threads() { return _threads; }
+
+  // the trailing zero trits of a message with its nonce
+  unsigned trailingZeros(uint8_t const *msg, size_t len);
+  // zeros needed for min_score
+  static unsigned targetZeros(size_t len, uint32_t min_score);
+
+private:
+  // Curl of POW_LANES nonces from base, returns the offset of the hash
+  static int hash(int8_t const *digest, uint64_t base, pow_lane_t *state);
+  // returns the lane of the first nonce from base with target zeros, -1 if
+  // there is none
+  static int batch(int8_t const *digest, uint64_t base, unsigned target,
+                   pow_lane_t *state);
+  static void digestTrits(uint8_t const *msg, size_t len, int8_t *trits);
+#if POW_THREADS
+  void worker();
+#endif
+
+  int8_t _digest[POW_DIGEST_TRITS];
+  pow_lane_t *_state; // of search() and trailingZeros()
+  unsigned _target;
+  unsigned _threads;
+  bool _prepared;
+  uint64_t _nonce;
+  uint64_t _hashes;
+#if POW_THREADS
+  std::atomic<uint64_t> _next;
+  std::atomic<bool> _found;
+  std::atomic<bool> _cancelled;
+#else
+  uint64_t _next;
+  volatile bool _cancelled;
+#endif
+};
+
+#endif
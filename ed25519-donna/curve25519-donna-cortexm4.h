@@ -0,0 +1,305 @@
+/*
+	Public domain by Andrew M. <liquidsun@gmail.com>
+	See: https://github.com/floodyberry/curve25519-donna
+
+	Full radix 2^32 curve25519 implementation for ARMv7E-M (Cortex-M4/M7)
+
+	A number is 8 limbs of 32 bits below 2^256, reduced modulo 2^255-19 only
+	by curve25519_contract. Products are summed with UMAAL, which computes
+	a * b + lo + hi into lo:hi without overflow in one cycle, so a full
+	product row carries without any extra instruction. Elsewhere umaal is
+	plain C, which lets the same code be checked against the 32 bit
+	implementation on a host.
+*/
+
+typedef uint32_t bignum25519[8];
+typedef uint32_t bignum25519align16[8];
+
+#if defined(__ARM_ARCH_7EM__) && !defined(ED25519_NO_INLINE_ASM)
+	#define umaal(lo, hi, a, b) \
+		__asm__ ("umaal %0, %1, %2, %3" : "+r" (lo), "+r" (hi) : "r" (a), "r" (b))
+#else
+	#define umaal(lo, hi, a, b) { \
+		uint64_t umaal_t = mul32x32_64(a, b) + (lo) + (hi); \
+		lo = (uint32_t)umaal_t; \
+		hi = (uint32_t)(umaal_t >> 32); \
+	}
+#endif
+
+/* out = in */
+DONNA_INLINE static void
+curve25519_copy(bignum25519 out, const bignum25519 in) {
+	out[0] = in[0];
+	out[1] = in[1];
+	out[2] = in[2];
+	out[3] = in[3];
+	out[4] = in[4];
+	out[5] = in[5];
+	out[6] = in[6];
+	out[7] = in[7];
+}
+
+/* out += 38 * carry, 2^256 being 38 modulo 2^255-19 */
+DONNA_INLINE static void
+curve25519_fold(bignum25519 out, uint32_t carry) {
+	uint64_t c = mul32x32_64(carry, 38);
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		c += out[i];
+		out[i] = (uint32_t)c;
+		c >>= 32;
+	}
+	/* wrapped past 2^256 again, out is then small enough to take 38 * c */
+	out[0] += (uint32_t)c * 38;
+}
+
+/* out = a + b */
+DONNA_INLINE static void
+curve25519_add(bignum25519 out, const bignum25519 a, const bignum25519 b) {
+	uint64_t c = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		c += (uint64_t)a[i] + b[i];
+		out[i] = (uint32_t)c;
+		c >>= 32;
+	}
+	curve25519_fold(out, (uint32_t)c);
+}
+
+/* all limbs are carried, nothing to do after an add or a sub */
+#define curve25519_add_after_basic curve25519_add
+#define curve25519_add_reduce curve25519_add
+
+/* out = a - b */
+DONNA_INLINE static void
+curve25519_sub(bignum25519 out, const bignum25519 a, const bignum25519 b) {
+	uint64_t d;
+	uint32_t borrow = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		d = (uint64_t)a[i] - b[i] - borrow;
+		out[i] = (uint32_t)d;
+		borrow = (uint32_t)(d >> 63);
+	}
+
+	/* out = a - b + 2^256, take 38 back off */
+	d = (uint64_t)out[0] - (borrow * 38);
+	out[0] = (uint32_t)d;
+	borrow = (uint32_t)(d >> 63);
+	for (i = 1; i < 8; i++) {
+		d = (uint64_t)out[i] - borrow;
+		out[i] = (uint32_t)d;
+		borrow = (uint32_t)(d >> 63);
+	}
+	/* wrapped below 0 again, so out is now above 2^256-38 */
+	out[0] -= borrow * 38;
+}
+
+#define curve25519_sub_after_basic curve25519_sub
+#define curve25519_sub_reduce curve25519_sub
+
+/* out = -a */
+DONNA_INLINE static void
+curve25519_neg(bignum25519 out, const bignum25519 a) {
+	static const bignum25519 zero = {0};
+	curve25519_sub(out, zero, a);
+}
+
+/* out = t mod 2^256-38, t a 512 bit product */
+DONNA_INLINE static void
+curve25519_reduce_product(bignum25519 out, const uint32_t t[16]) {
+	uint32_t lo, hi = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		lo = t[i];
+		umaal(lo, hi, t[i + 8], 38);
+		out[i] = lo;
+	}
+	curve25519_fold(out, hi);
+}
+
+/* out = a * b */
+static void
+curve25519_mul(bignum25519 out, const bignum25519 a, const bignum25519 b) {
+	uint32_t t[16];
+	uint32_t lo, hi, ai;
+	int i, j;
+
+	/* operand scanning, one row of a[i] * b per pass */
+	ai = a[0];
+	hi = 0;
+	for (j = 0; j < 8; j++) {
+		lo = 0;
+		umaal(lo, hi, ai, b[j]);
+		t[j] = lo;
+	}
+	t[8] = hi;
+
+	for (i = 1; i < 8; i++) {
+		ai = a[i];
+		hi = 0;
+		for (j = 0; j < 8; j++) {
+			lo = t[i + j];
+			umaal(lo, hi, ai, b[j]);
+			t[i + j] = lo;
+		}
+		t[i + 8] = hi;
+	}
+
+	curve25519_reduce_product(out, t);
+}
+
+DONNA_NOINLINE static void
+curve25519_mul_noinline(bignum25519 out, const bignum25519 a, const bignum25519 b) {
+	curve25519_mul(out, a, b);
+}
+
+/* out = in * in */
+static void
+curve25519_square(bignum25519 out, const bignum25519 in) {
+	uint32_t t[16];
+	uint32_t lo, hi, ai;
+	uint64_t c;
+	int i, j;
+
+	/* the products a[i] * a[j] with i < j, once */
+	for (i = 0; i < 16; i++)
+		t[i] = 0;
+	for (i = 0; i < 7; i++) {
+		ai = in[i];
+		hi = 0;
+		for (j = i + 1; j < 8; j++) {
+			lo = t[i + j];
+			umaal(lo, hi, ai, in[j]);
+			t[i + j] = lo;
+		}
+		t[i + 8] = hi;
+	}
+
+	/* twice, then the squares a[i] * a[i] */
+	for (i = 15; i > 0; i--)
+		t[i] = (t[i] << 1) | (t[i - 1] >> 31);
+	t[0] <<= 1;
+
+	hi = 0;
+	for (i = 0; i < 8; i++) {
+		lo = t[2 * i];
+		umaal(lo, hi, in[i], in[i]);
+		t[2 * i] = lo;
+		c = (uint64_t)t[2 * i + 1] + hi;
+		t[2 * i + 1] = (uint32_t)c;
+		hi = (uint32_t)(c >> 32);
+	}
+
+	curve25519_reduce_product(out, t);
+}
+
+/* out = in ^ (2 * count) */
+static void
+curve25519_square_times(bignum25519 out, const bignum25519 in, int count) {
+	curve25519_square(out, in);
+	while (--count > 0)
+		curve25519_square(out, out);
+}
+
+/* Take a little-endian, 32-byte number and expand it into limbs */
+static void
+curve25519_expand(bignum25519 out, const unsigned char in[32]) {
+	static const union { uint8_t b[2]; uint16_t s; } endian_check = {{1,0}};
+	int i;
+
+	if (endian_check.s == 1) {
+		for (i = 0; i < 8; i++)
+			out[i] = *(uint32_t *)(in + 4 * i);
+	} else {
+		for (i = 0; i < 8; i++) {
+			out[i] = (((uint32_t)in[4 * i + 0])      ) |
+			         (((uint32_t)in[4 * i + 1]) <<  8) |
+			         (((uint32_t)in[4 * i + 2]) << 16) |
+			         (((uint32_t)in[4 * i + 3]) << 24);
+		}
+	}
+	/* the top bit is not part of the number */
+	out[7] &= 0x7fffffff;
+}
+
+/* out = in + 19 * (in >> 255), in mod 2^255 */
+DONNA_INLINE static void
+curve25519_fold255(bignum25519 f) {
+	uint64_t c = (uint64_t)(f[7] >> 31) * 19;
+	int i;
+
+	f[7] &= 0x7fffffff;
+	for (i = 0; i < 8; i++) {
+		c += f[i];
+		f[i] = (uint32_t)c;
+		c >>= 32;
+	}
+}
+
+/* Take a number below 2^256, reduce it fully and contract it into a
+ * little-endian, 32-byte array
+ */
+static void
+curve25519_contract(unsigned char out[32], const bignum25519 in) {
+	bignum25519 f, g;
+	uint64_t c;
+	uint32_t mask;
+	int i;
+
+	curve25519_copy(f, in);
+
+	/* below 2^255 + 19 after the first fold, below 2^255 after the second */
+	curve25519_fold255(f);
+	curve25519_fold255(f);
+
+	/* f >= 2^255-19 exactly when f + 19 reaches 2^255 */
+	c = 19;
+	for (i = 0; i < 8; i++) {
+		c += f[i];
+		g[i] = (uint32_t)c;
+		c >>= 32;
+	}
+	mask = (uint32_t)-(int32_t)(g[7] >> 31);
+	g[7] &= 0x7fffffff;
+	for (i = 0; i < 8; i++)
+		f[i] = (g[i] & mask) | (f[i] & ~mask);
+
+	for (i = 0; i < 8; i++) {
+		out[4 * i + 0] = (unsigned char)(f[i]      );
+		out[4 * i + 1] = (unsigned char)(f[i] >>  8);
+		out[4 * i + 2] = (unsigned char)(f[i] >> 16);
+		out[4 * i + 3] = (unsigned char)(f[i] >> 24);
+	}
+}
+
+
+/* out = (flag) ? in : out */
+DONNA_INLINE static void
+curve25519_move_conditional_bytes(uint8_t out[96], const uint8_t in[96], uint32_t flag) {
+	const uint32_t nb = flag - 1, b = ~nb;
+	const uint32_t *inl = (const uint32_t *)in;
+	uint32_t *outl = (uint32_t *)out;
+	int i;
+
+	for (i = 0; i < 24; i++)
+		outl[i] = (outl[i] & nb) | (inl[i] & b);
+}
+
+/* if (iswap) swap(a, b) */
+DONNA_INLINE static void
+curve25519_swap_conditional(bignum25519 a, bignum25519 b, uint32_t iswap) {
+	const uint32_t swap = (uint32_t)(-(int32_t)iswap);
+	uint32_t x;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		x = swap & (a[i] ^ b[i]);
+		a[i] ^= x;
+		b[i] ^= x;
+	}
+}
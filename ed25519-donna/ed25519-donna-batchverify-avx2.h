@@ -0,0 +1,434 @@
+/*
+	AVX2 backend for batch verification
+
+	Limbs in the radix 2^25.5 of curve25519-donna-32bit.h, so that
+	_mm256_mul_epu32 forms the 32x32 bit products of all four lanes at once.
+	Points are added with the parallel formulas of Hisil, Wong, Carter and
+	Dawson, "Twisted Edwards Curves Revisited", section 4.2: one 4-way
+	multiplication forms A, B, C and D, a second one x, y, z and t.
+*/
+
+#include <immintrin.h>
+
+#define AVX2_INLINE static inline __attribute__((target("avx2"), always_inline))
+#define AVX2_NOINLINE static __attribute__((target("avx2"), noinline))
+
+typedef __m256i bignum25519avx2[10];
+
+AVX2_INLINE void
+curve25519_avx2_load(bignum25519avx2 r, const bignum25519x4 *in) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		r[i] = _mm256_load_si256((const __m256i *)in->v[i]);
+}
+
+AVX2_INLINE void
+curve25519_avx2_store(bignum25519x4 *out, const bignum25519avx2 a) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		_mm256_store_si256((__m256i *)out->v[i], a[i]);
+}
+
+AVX2_INLINE void
+curve25519_avx2_copy(bignum25519avx2 r, const bignum25519avx2 a) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		r[i] = a[i];
+}
+
+/* c = 19 * c without a 64 bit multiply */
+AVX2_INLINE __m256i
+curve25519_avx2_mul19(__m256i c) {
+	return _mm256_add_epi64(c, _mm256_add_epi64(_mm256_slli_epi64(c, 1), _mm256_slli_epi64(c, 4)));
+}
+
+/* carry 64 bit limbs down to 26/25 bits, limbs 1 and 6 may stay a little above */
+AVX2_INLINE void
+curve25519_avx2_carry(bignum25519avx2 r) {
+	const __m256i m26 = _mm256_set1_epi64x(0x3ffffff), m25 = _mm256_set1_epi64x(0x1ffffff);
+	__m256i c, d;
+
+	/* limbs 0..4 and 5..9 in parallel */
+	#define carry_pair(i, si, mi, j, sj, mj) \
+		c = _mm256_srli_epi64(r[i], si); r[i] = _mm256_and_si256(r[i], mi); \
+		d = _mm256_srli_epi64(r[j], sj); r[j] = _mm256_and_si256(r[j], mj);
+
+	carry_pair(0, 26, m26, 5, 25, m25) r[1] = _mm256_add_epi64(r[1], c); r[6] = _mm256_add_epi64(r[6], d);
+	carry_pair(1, 25, m25, 6, 26, m26) r[2] = _mm256_add_epi64(r[2], c); r[7] = _mm256_add_epi64(r[7], d);
+	carry_pair(2, 26, m26, 7, 25, m25) r[3] = _mm256_add_epi64(r[3], c); r[8] = _mm256_add_epi64(r[8], d);
+	carry_pair(3, 25, m25, 8, 26, m26) r[4] = _mm256_add_epi64(r[4], c); r[9] = _mm256_add_epi64(r[9], d);
+	carry_pair(4, 26, m26, 9, 25, m25) r[5] = _mm256_add_epi64(r[5], c); r[0] = _mm256_add_epi64(r[0], curve25519_avx2_mul19(d));
+	carry_pair(0, 26, m26, 5, 25, m25) r[1] = _mm256_add_epi64(r[1], c); r[6] = _mm256_add_epi64(r[6], d);
+
+	#undef carry_pair
+}
+
+/* r = a + b, not carried */
+AVX2_INLINE void
+curve25519_avx2_add(bignum25519avx2 r, const bignum25519avx2 a, const bignum25519avx2 b) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		r[i] = _mm256_add_epi64(a[i], b[i]);
+}
+
+/* r = a + 2p - b, b carried */
+AVX2_INLINE void
+curve25519_avx2_sub(bignum25519avx2 r, const bignum25519avx2 a, const bignum25519avx2 b) {
+	const __m256i twop0 = _mm256_set1_epi64x(0x7ffffda);
+	const __m256i twop25 = _mm256_set1_epi64x(0x3fffffe);
+	const __m256i twop26 = _mm256_set1_epi64x(0x7fffffe);
+	int i;
+
+	r[0] = _mm256_sub_epi64(_mm256_add_epi64(a[0], twop0), b[0]);
+	ED25519_X4_UNROLL
+	for (i = 1; i < 10; i++)
+		r[i] = _mm256_sub_epi64(_mm256_add_epi64(a[i], (i & 1) ? twop25 : twop26), b[i]);
+	curve25519_avx2_carry(r);
+}
+
+/*
+	r = a * b, limbs of a and b at most the sum of two carried limbs: 19 * b
+	fits the 32 bit multiplier input, the ten products of a limb 2^62.8
+*/
+AVX2_INLINE void
+curve25519_avx2_mul(bignum25519avx2 r, const bignum25519avx2 a, const bignum25519avx2 b) {
+	const __m256i nineteen = _mm256_set1_epi64x(19);
+	__m256i a2[10], b19[10], z[10];
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 1; i < 10; i += 2)
+		a2[i] = _mm256_add_epi64(a[i], a[i]);
+	ED25519_X4_UNROLL
+	for (i = 1; i < 10; i++)
+		b19[i] = _mm256_mul_epu32(b[i], nineteen);
+
+	z[0] = _mm256_mul_epu32(a[0], b[0]);
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[1], b19[9]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a[2], b19[8]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[3], b19[7]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a[4], b19[6]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[5], b19[5]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a[6], b19[4]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[7], b19[3]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a[8], b19[2]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[9], b19[1]));
+	z[1] = _mm256_mul_epu32(a[0], b[1]);
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[1], b[0]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[2], b19[9]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[3], b19[8]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[4], b19[7]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[5], b19[6]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[6], b19[5]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[7], b19[4]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[8], b19[3]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a[9], b19[2]));
+	z[2] = _mm256_mul_epu32(a[0], b[2]);
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[1], b[1]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a[2], b[0]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[3], b19[9]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a[4], b19[8]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[5], b19[7]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a[6], b19[6]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[7], b19[5]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a[8], b19[4]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[9], b19[3]));
+	z[3] = _mm256_mul_epu32(a[0], b[3]);
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[1], b[2]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[2], b[1]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[3], b[0]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[4], b19[9]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[5], b19[8]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[6], b19[7]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[7], b19[6]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[8], b19[5]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a[9], b19[4]));
+	z[4] = _mm256_mul_epu32(a[0], b[4]);
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[1], b[3]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a[2], b[2]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[3], b[1]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a[4], b[0]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[5], b19[9]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a[6], b19[8]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[7], b19[7]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a[8], b19[6]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[9], b19[5]));
+	z[5] = _mm256_mul_epu32(a[0], b[5]);
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[1], b[4]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[2], b[3]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[3], b[2]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[4], b[1]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[5], b[0]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[6], b19[9]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[7], b19[8]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[8], b19[7]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a[9], b19[6]));
+	z[6] = _mm256_mul_epu32(a[0], b[6]);
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[1], b[5]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a[2], b[4]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[3], b[3]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a[4], b[2]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[5], b[1]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a[6], b[0]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[7], b19[9]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a[8], b19[8]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[9], b19[7]));
+	z[7] = _mm256_mul_epu32(a[0], b[7]);
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[1], b[6]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[2], b[5]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[3], b[4]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[4], b[3]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[5], b[2]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[6], b[1]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[7], b[0]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[8], b19[9]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a[9], b19[8]));
+	z[8] = _mm256_mul_epu32(a[0], b[8]);
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[1], b[7]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a[2], b[6]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[3], b[5]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a[4], b[4]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[5], b[3]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a[6], b[2]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[7], b[1]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a[8], b[0]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[9], b19[9]));
+	z[9] = _mm256_mul_epu32(a[0], b[9]);
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[1], b[8]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[2], b[7]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[3], b[6]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[4], b[5]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[5], b[4]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[6], b[3]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[7], b[2]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[8], b[1]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a[9], b[0]));
+
+	curve25519_avx2_carry(z);
+	curve25519_avx2_copy(r, z);
+}
+
+/* r = a * a, a carried so that 38 * a fits the 32 bit multiplier input */
+AVX2_INLINE void
+curve25519_avx2_square(bignum25519avx2 r, const bignum25519avx2 a) {
+	const __m256i nineteen = _mm256_set1_epi64x(19);
+	__m256i a2[10], a19[10], a38[10], z[10];
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		a2[i] = _mm256_add_epi64(a[i], a[i]);
+	ED25519_X4_UNROLL
+	for (i = 5; i < 10; i++)
+		a19[i] = _mm256_mul_epu32(a[i], nineteen);
+	a38[7] = _mm256_add_epi64(a19[7], a19[7]);
+	a38[9] = _mm256_add_epi64(a19[9], a19[9]);
+
+	z[0] = _mm256_mul_epu32(a[0], a[0]);
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[1], a38[9]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[2], a19[8]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[3], a38[7]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[4], a19[6]));
+	z[0] = _mm256_add_epi64(z[0], _mm256_mul_epu32(a2[5], a19[5]));
+	z[1] = _mm256_mul_epu32(a2[0], a[1]);
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a2[2], a19[9]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a2[3], a19[8]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a2[4], a19[7]));
+	z[1] = _mm256_add_epi64(z[1], _mm256_mul_epu32(a2[5], a19[6]));
+	z[2] = _mm256_mul_epu32(a2[0], a[2]);
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[1], a[1]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[3], a38[9]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[4], a19[8]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a2[5], a38[7]));
+	z[2] = _mm256_add_epi64(z[2], _mm256_mul_epu32(a[6], a19[6]));
+	z[3] = _mm256_mul_epu32(a2[0], a[3]);
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a2[1], a[2]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a2[4], a19[9]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a2[5], a19[8]));
+	z[3] = _mm256_add_epi64(z[3], _mm256_mul_epu32(a2[6], a19[7]));
+	z[4] = _mm256_mul_epu32(a2[0], a[4]);
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[1], a2[3]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a[2], a[2]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[5], a38[9]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[6], a19[8]));
+	z[4] = _mm256_add_epi64(z[4], _mm256_mul_epu32(a2[7], a19[7]));
+	z[5] = _mm256_mul_epu32(a2[0], a[5]);
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a2[1], a[4]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a2[2], a[3]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a2[6], a19[9]));
+	z[5] = _mm256_add_epi64(z[5], _mm256_mul_epu32(a2[7], a19[8]));
+	z[6] = _mm256_mul_epu32(a2[0], a[6]);
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[1], a2[5]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[2], a[4]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[3], a[3]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a2[7], a38[9]));
+	z[6] = _mm256_add_epi64(z[6], _mm256_mul_epu32(a[8], a19[8]));
+	z[7] = _mm256_mul_epu32(a2[0], a[7]);
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a2[1], a[6]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a2[2], a[5]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a2[3], a[4]));
+	z[7] = _mm256_add_epi64(z[7], _mm256_mul_epu32(a2[8], a19[9]));
+	z[8] = _mm256_mul_epu32(a2[0], a[8]);
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[1], a2[7]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[2], a[6]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[3], a2[5]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a[4], a[4]));
+	z[8] = _mm256_add_epi64(z[8], _mm256_mul_epu32(a2[9], a19[9]));
+	z[9] = _mm256_mul_epu32(a2[0], a[9]);
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a2[1], a[8]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a2[2], a[7]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a2[3], a[6]));
+	z[9] = _mm256_add_epi64(z[9], _mm256_mul_epu32(a2[4], a[5]));
+
+	curve25519_avx2_carry(z);
+	curve25519_avx2_copy(r, z);
+}
+
+AVX2_NOINLINE void
+curve25519_avx2_mul_noinline(bignum25519avx2 r, const bignum25519avx2 a, const bignum25519avx2 b) {
+	curve25519_avx2_mul(r, a, b);
+}
+
+AVX2_NOINLINE void
+curve25519_avx2_square_times(bignum25519avx2 r, const bignum25519avx2 a, int count) {
+	bignum25519avx2 t;
+	curve25519_avx2_square(t, a);
+	while (--count)
+		curve25519_avx2_square(t, t);
+	curve25519_avx2_copy(r, t);
+}
+
+/* z^(2^252 - 3), the chain of curve25519_pow_two252m3 */
+AVX2_NOINLINE void
+curve25519_avx2_pow_two252m3(bignum25519avx2 two252m3, const bignum25519avx2 z) {
+	bignum25519avx2 b, c, t0;
+
+	/* 2 */ curve25519_avx2_square_times(c, z, 1);
+	/* 8 */ curve25519_avx2_square_times(t0, c, 2);
+	/* 9 */ curve25519_avx2_mul_noinline(b, t0, z);
+	/* 11 */ curve25519_avx2_mul_noinline(c, b, c);
+	/* 22 */ curve25519_avx2_square_times(t0, c, 1);
+	/* 2^5 - 2^0 = 31 */ curve25519_avx2_mul_noinline(b, t0, b);
+	/* 2^10 - 2^5 */ curve25519_avx2_square_times(t0, b, 5);
+	/* 2^10 - 2^0 */ curve25519_avx2_mul_noinline(b, t0, b);
+	/* 2^20 - 2^10 */ curve25519_avx2_square_times(t0, b, 10);
+	/* 2^20 - 2^0 */ curve25519_avx2_mul_noinline(c, t0, b);
+	/* 2^40 - 2^20 */ curve25519_avx2_square_times(t0, c, 20);
+	/* 2^40 - 2^0 */ curve25519_avx2_mul_noinline(t0, t0, c);
+	/* 2^50 - 2^10 */ curve25519_avx2_square_times(t0, t0, 10);
+	/* 2^50 - 2^0 */ curve25519_avx2_mul_noinline(b, t0, b);
+	/* 2^100 - 2^50 */ curve25519_avx2_square_times(t0, b, 50);
+	/* 2^100 - 2^0 */ curve25519_avx2_mul_noinline(c, t0, b);
+	/* 2^200 - 2^100 */ curve25519_avx2_square_times(t0, c, 100);
+	/* 2^200 - 2^0 */ curve25519_avx2_mul_noinline(t0, t0, c);
+	/* 2^250 - 2^50 */ curve25519_avx2_square_times(t0, t0, 50);
+	/* 2^250 - 2^0 */ curve25519_avx2_mul_noinline(b, t0, b);
+	/* 2^252 - 2^2 */ curve25519_avx2_square_times(b, b, 2);
+	/* 2^252 - 3 */ curve25519_avx2_mul_noinline(two252m3, b, z);
+}
+
+/* lanes x, y, z, t to y - x, y + x, t, z */
+AVX2_INLINE void
+ge25519_avx2_prepare(bignum25519avx2 r, const bignum25519avx2 p) {
+	bignum25519avx2 s, u, sum, diff;
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		s[i] = _mm256_permute4x64_epi64(p[i], _MM_SHUFFLE(2, 3, 1, 1));
+		u[i] = _mm256_permute4x64_epi64(p[i], _MM_SHUFFLE(0, 0, 0, 0));
+		u[i] = _mm256_blend_epi32(u[i], _mm256_setzero_si256(), 0xf0);
+	}
+	curve25519_avx2_add(sum, s, u);
+	curve25519_avx2_sub(diff, s, u);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		r[i] = _mm256_blend_epi32(sum[i], diff[i], 0x03);
+}
+
+/*
+	r = p + q
+
+	q is scaled by 121666, which turns 2d into the small -2 * 121665:
+	A = (y1 - x1)(y2 - x2), B = (y1 + x1)(y2 + x2), C = -t1 2d t2, D = 2 z1 z2
+	E = B - A, F = D + C, G = D - C, H = B + A
+	x3 = E F, y3 = G H, z3 = F G, t3 = E H
+*/
+static void __attribute__((target("avx2")))
+ge25519_add_avx2(bignum25519x4 *r, const bignum25519x4 *p, const bignum25519x4 *q) {
+	const __m256i scale = _mm256_setr_epi64x(121666, 121666, 2 * 121665, 2 * 121666);
+	bignum25519avx2 a, b, m, s, u, sum, diff;
+	int i;
+
+	curve25519_avx2_load(m, p);
+	ge25519_avx2_prepare(a, m);
+	curve25519_avx2_load(m, q);
+	ge25519_avx2_prepare(b, m);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		b[i] = _mm256_mul_epu32(b[i], scale);
+	curve25519_avx2_carry(b);
+
+	/* A, B, C, D */
+	curve25519_avx2_mul(m, a, b);
+
+	/* E, H, F, G */
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		s[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(3, 3, 1, 1));
+		u[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(2, 2, 0, 0));
+	}
+	curve25519_avx2_add(sum, s, u);
+	curve25519_avx2_sub(diff, s, u);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		m[i] = _mm256_blend_epi32(sum[i], diff[i], 0xc3);
+		a[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(0, 2, 3, 0));
+		b[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(1, 3, 1, 2));
+	}
+
+	/* E F, G H, F G, E H */
+	curve25519_avx2_mul(m, a, b);
+	curve25519_avx2_store(r, m);
+}
+
+/* num = y^2 - 1, den = d y^2 + 1, x = num den^3 (num den^7)^((p-5)/8) */
+static void __attribute__((target("avx2")))
+ge25519_root_avx2(bignum25519x4 *x, bignum25519x4 *num, bignum25519x4 *den, const bignum25519x4 *y) {
+	static const uint32_t ecd[10] = {
+		0x035978a3,0x00d37284,0x03156ebd,0x006a0a0e,0x0001c029,0x0179e898,0x03a03cbb,0x01ce7198,0x02e2b6ff,0x01480db3
+	};
+	bignum25519avx2 r, n, d, d3, t, one;
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		t[i] = _mm256_set1_epi64x(ecd[i]);
+		one[i] = _mm256_setzero_si256();
+	}
+	one[0] = _mm256_set1_epi64x(1);
+
+	curve25519_avx2_load(r, y);
+	curve25519_avx2_square(n, r);
+	curve25519_avx2_mul(d, n, t);
+	curve25519_avx2_sub(n, n, one);
+	curve25519_avx2_add(d, d, one);
+	curve25519_avx2_carry(d);
+
+	curve25519_avx2_square(t, d);
+	curve25519_avx2_mul(d3, t, d);
+	curve25519_avx2_square(r, d3);
+	curve25519_avx2_mul(r, r, d);
+	curve25519_avx2_mul(r, r, n);
+	curve25519_avx2_pow_two252m3(r, r);
+	curve25519_avx2_mul(r, r, d3);
+	curve25519_avx2_mul(r, r, n);
+
+	curve25519_avx2_store(x, r);
+	curve25519_avx2_store(num, n);
+	curve25519_avx2_store(den, d);
+}
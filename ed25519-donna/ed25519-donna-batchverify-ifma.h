@@ -0,0 +1,297 @@
+/*
+	AVX-512 IFMA backend for batch verification
+
+	Limbs in the radix 2^51 of curve25519-donna-64bit.h. vpmadd52luq and
+	vpmadd52huq add the low and the high 52 bits of the 52x52 bit products
+	of all four lanes, the high half lands one limb up and twice over since
+	2^52 = 2 * 2^51. The multiplier only reads 52 bits, so sums are carried
+	before they are multiplied. Same formulas as the AVX2 backend.
+*/
+
+#define IFMA_TARGET __attribute__((target("avx2,avx512f,avx512vl,avx512ifma")))
+#define IFMA_INLINE static inline IFMA_TARGET __attribute__((always_inline))
+#define IFMA_NOINLINE static IFMA_TARGET __attribute__((noinline))
+
+typedef __m256i bignum25519ifma[5];
+
+IFMA_INLINE void
+curve25519_ifma_load(bignum25519ifma r, const bignum25519x4 *in) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++)
+		r[i] = _mm256_load_si256((const __m256i *)in->v[i]);
+}
+
+IFMA_INLINE void
+curve25519_ifma_store(bignum25519x4 *out, const bignum25519ifma a) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++)
+		_mm256_store_si256((__m256i *)out->v[i], a[i]);
+}
+
+IFMA_INLINE __m256i
+curve25519_ifma_mul19(__m256i c) {
+	return _mm256_add_epi64(c, _mm256_add_epi64(_mm256_slli_epi64(c, 1), _mm256_slli_epi64(c, 4)));
+}
+
+/* carry 64 bit limbs down to 51 bits, limbs 1 and 3 may stay a little above */
+IFMA_INLINE void
+curve25519_ifma_carry(bignum25519ifma r) {
+	const __m256i m51 = _mm256_set1_epi64x(0x7ffffffffffff);
+	__m256i c, d;
+
+	/* limbs 0..2 and 3..4 in parallel */
+	c = _mm256_srli_epi64(r[0], 51); r[0] = _mm256_and_si256(r[0], m51);
+	d = _mm256_srli_epi64(r[3], 51); r[3] = _mm256_and_si256(r[3], m51);
+	r[1] = _mm256_add_epi64(r[1], c); r[4] = _mm256_add_epi64(r[4], d);
+	c = _mm256_srli_epi64(r[1], 51); r[1] = _mm256_and_si256(r[1], m51);
+	d = _mm256_srli_epi64(r[4], 51); r[4] = _mm256_and_si256(r[4], m51);
+	r[2] = _mm256_add_epi64(r[2], c); r[0] = _mm256_add_epi64(r[0], curve25519_ifma_mul19(d));
+	c = _mm256_srli_epi64(r[2], 51); r[2] = _mm256_and_si256(r[2], m51);
+	d = _mm256_srli_epi64(r[0], 51); r[0] = _mm256_and_si256(r[0], m51);
+	r[3] = _mm256_add_epi64(r[3], c); r[1] = _mm256_add_epi64(r[1], d);
+}
+
+/* r = a + b, carried */
+IFMA_INLINE void
+curve25519_ifma_add(bignum25519ifma r, const bignum25519ifma a, const bignum25519ifma b) {
+	int i;
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++)
+		r[i] = _mm256_add_epi64(a[i], b[i]);
+	curve25519_ifma_carry(r);
+}
+
+/* r = a + 2p - b, b carried */
+IFMA_INLINE void
+curve25519_ifma_sub(bignum25519ifma r, const bignum25519ifma a, const bignum25519ifma b) {
+	const __m256i twop0 = _mm256_set1_epi64x(0xfffffffffffda);
+	const __m256i twop = _mm256_set1_epi64x(0xffffffffffffe);
+	int i;
+
+	r[0] = _mm256_sub_epi64(_mm256_add_epi64(a[0], twop0), b[0]);
+	ED25519_X4_UNROLL
+	for (i = 1; i < 5; i++)
+		r[i] = _mm256_sub_epi64(_mm256_add_epi64(a[i], twop), b[i]);
+	curve25519_ifma_carry(r);
+}
+
+/* z = lo + 2 hi, folded above 2^255 with 19, into r */
+IFMA_INLINE void
+curve25519_ifma_reduce(bignum25519ifma r, const __m256i lo[10], const __m256i hi[10]) {
+	__m256i z[10];
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++)
+		z[i] = _mm256_add_epi64(lo[i], _mm256_add_epi64(hi[i], hi[i]));
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++)
+		r[i] = _mm256_add_epi64(z[i], curve25519_ifma_mul19(z[i + 5]));
+	curve25519_ifma_carry(r);
+}
+
+/* r = a * b, a and b carried */
+IFMA_INLINE void
+curve25519_ifma_mul(bignum25519ifma r, const bignum25519ifma a, const bignum25519ifma b) {
+	__m256i lo[10], hi[10];
+	int i, j;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		lo[i] = _mm256_setzero_si256();
+		hi[i] = _mm256_setzero_si256();
+	}
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		ED25519_X4_UNROLL
+		for (j = 0; j < 5; j++) {
+			lo[i + j] = _mm256_madd52lo_epu64(lo[i + j], a[i], b[j]);
+			hi[i + j + 1] = _mm256_madd52hi_epu64(hi[i + j + 1], a[i], b[j]);
+		}
+	}
+	curve25519_ifma_reduce(r, lo, hi);
+}
+
+/* r = a * a, the products of two different limbs once and doubled */
+IFMA_INLINE void
+curve25519_ifma_square(bignum25519ifma r, const bignum25519ifma a) {
+	__m256i lo[10], hi[10];
+	int i, j;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		lo[i] = _mm256_setzero_si256();
+		hi[i] = _mm256_setzero_si256();
+	}
+	ED25519_X4_UNROLL
+	for (i = 0; i < 4; i++) {
+		ED25519_X4_UNROLL
+		for (j = i + 1; j < 5; j++) {
+			lo[i + j] = _mm256_madd52lo_epu64(lo[i + j], a[i], a[j]);
+			hi[i + j + 1] = _mm256_madd52hi_epu64(hi[i + j + 1], a[i], a[j]);
+		}
+	}
+	/* 2 a[i] may not fit the 52 bit input, double the sums instead */
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		lo[i] = _mm256_add_epi64(lo[i], lo[i]);
+		hi[i] = _mm256_add_epi64(hi[i], hi[i]);
+	}
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		lo[2 * i] = _mm256_madd52lo_epu64(lo[2 * i], a[i], a[i]);
+		hi[2 * i + 1] = _mm256_madd52hi_epu64(hi[2 * i + 1], a[i], a[i]);
+	}
+	curve25519_ifma_reduce(r, lo, hi);
+}
+
+IFMA_NOINLINE void
+curve25519_ifma_mul_noinline(bignum25519ifma r, const bignum25519ifma a, const bignum25519ifma b) {
+	curve25519_ifma_mul(r, a, b);
+}
+
+IFMA_NOINLINE void
+curve25519_ifma_square_times(bignum25519ifma r, const bignum25519ifma a, int count) {
+	bignum25519ifma t;
+	int i;
+
+	curve25519_ifma_square(t, a);
+	while (--count)
+		curve25519_ifma_square(t, t);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++)
+		r[i] = t[i];
+}
+
+/* z^(2^252 - 3), the chain of curve25519_pow_two252m3 */
+IFMA_NOINLINE void
+curve25519_ifma_pow_two252m3(bignum25519ifma two252m3, const bignum25519ifma z) {
+	bignum25519ifma b, c, t0;
+
+	/* 2 */ curve25519_ifma_square_times(c, z, 1);
+	/* 8 */ curve25519_ifma_square_times(t0, c, 2);
+	/* 9 */ curve25519_ifma_mul_noinline(b, t0, z);
+	/* 11 */ curve25519_ifma_mul_noinline(c, b, c);
+	/* 22 */ curve25519_ifma_square_times(t0, c, 1);
+	/* 2^5 - 2^0 = 31 */ curve25519_ifma_mul_noinline(b, t0, b);
+	/* 2^10 - 2^5 */ curve25519_ifma_square_times(t0, b, 5);
+	/* 2^10 - 2^0 */ curve25519_ifma_mul_noinline(b, t0, b);
+	/* 2^20 - 2^10 */ curve25519_ifma_square_times(t0, b, 10);
+	/* 2^20 - 2^0 */ curve25519_ifma_mul_noinline(c, t0, b);
+	/* 2^40 - 2^20 */ curve25519_ifma_square_times(t0, c, 20);
+	/* 2^40 - 2^0 */ curve25519_ifma_mul_noinline(t0, t0, c);
+	/* 2^50 - 2^10 */ curve25519_ifma_square_times(t0, t0, 10);
+	/* 2^50 - 2^0 */ curve25519_ifma_mul_noinline(b, t0, b);
+	/* 2^100 - 2^50 */ curve25519_ifma_square_times(t0, b, 50);
+	/* 2^100 - 2^0 */ curve25519_ifma_mul_noinline(c, t0, b);
+	/* 2^200 - 2^100 */ curve25519_ifma_square_times(t0, c, 100);
+	/* 2^200 - 2^0 */ curve25519_ifma_mul_noinline(t0, t0, c);
+	/* 2^250 - 2^50 */ curve25519_ifma_square_times(t0, t0, 50);
+	/* 2^250 - 2^0 */ curve25519_ifma_mul_noinline(b, t0, b);
+	/* 2^252 - 2^2 */ curve25519_ifma_square_times(b, b, 2);
+	/* 2^252 - 3 */ curve25519_ifma_mul_noinline(two252m3, b, z);
+}
+
+/* lanes x, y, z, t to y - x, y + x, t, z */
+IFMA_INLINE void
+ge25519_ifma_prepare(bignum25519ifma r, const bignum25519ifma p) {
+	bignum25519ifma s, u, sum, diff;
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		s[i] = _mm256_permute4x64_epi64(p[i], _MM_SHUFFLE(2, 3, 1, 1));
+		u[i] = _mm256_permute4x64_epi64(p[i], _MM_SHUFFLE(0, 0, 0, 0));
+		u[i] = _mm256_blend_epi32(u[i], _mm256_setzero_si256(), 0xf0);
+	}
+	curve25519_ifma_add(sum, s, u);
+	curve25519_ifma_sub(diff, s, u);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++)
+		r[i] = _mm256_blend_epi32(sum[i], diff[i], 0x03);
+}
+
+/* r = p + q, see ge25519_add_avx2 */
+static void IFMA_TARGET
+ge25519_add_ifma(bignum25519x4 *r, const bignum25519x4 *p, const bignum25519x4 *q) {
+	const __m256i scale = _mm256_setr_epi64x(121666, 121666, 2 * 121665, 2 * 121666);
+	__m256i lo[10], hi[10];
+	bignum25519ifma a, b, m, s, u, sum, diff;
+	int i;
+
+	curve25519_ifma_load(m, p);
+	ge25519_ifma_prepare(a, m);
+	curve25519_ifma_load(m, q);
+	ge25519_ifma_prepare(b, m);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 10; i++) {
+		lo[i] = _mm256_setzero_si256();
+		hi[i] = _mm256_setzero_si256();
+	}
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		lo[i] = _mm256_madd52lo_epu64(lo[i], b[i], scale);
+		hi[i + 1] = _mm256_madd52hi_epu64(hi[i + 1], b[i], scale);
+	}
+	curve25519_ifma_reduce(b, lo, hi);
+
+	/* A, B, C, D */
+	curve25519_ifma_mul(m, a, b);
+
+	/* E, H, F, G */
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		s[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(3, 3, 1, 1));
+		u[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(2, 2, 0, 0));
+	}
+	curve25519_ifma_add(sum, s, u);
+	curve25519_ifma_sub(diff, s, u);
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		m[i] = _mm256_blend_epi32(sum[i], diff[i], 0xc3);
+		a[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(0, 2, 3, 0));
+		b[i] = _mm256_permute4x64_epi64(m[i], _MM_SHUFFLE(1, 3, 1, 2));
+	}
+
+	/* E F, G H, F G, E H */
+	curve25519_ifma_mul(m, a, b);
+	curve25519_ifma_store(r, m);
+}
+
+/* num = y^2 - 1, den = d y^2 + 1, x = num den^3 (num den^7)^((p-5)/8) */
+static void IFMA_TARGET
+ge25519_root_ifma(bignum25519x4 *x, bignum25519x4 *num, bignum25519x4 *den, const bignum25519x4 *y) {
+	static const uint64_t ecd[5] = {
+		0x00034dca135978a3,0x0001a8283b156ebd,0x0005e7a26001c029,0x000739c663a03cbb,0x00052036cee2b6ff
+	};
+	bignum25519ifma r, n, d, d3, t, one;
+	int i;
+
+	ED25519_X4_UNROLL
+	for (i = 0; i < 5; i++) {
+		t[i] = _mm256_set1_epi64x(ecd[i]);
+		one[i] = _mm256_setzero_si256();
+	}
+	one[0] = _mm256_set1_epi64x(1);
+
+	curve25519_ifma_load(r, y);
+	curve25519_ifma_square(n, r);
+	curve25519_ifma_mul(d, n, t);
+	curve25519_ifma_sub(n, n, one);
+	curve25519_ifma_add(d, d, one);
+
+	curve25519_ifma_square(t, d);
+	curve25519_ifma_mul(d3, t, d);
+	curve25519_ifma_square(r, d3);
+	curve25519_ifma_mul(r, r, d);
+	curve25519_ifma_mul(r, r, n);
+	curve25519_ifma_pow_two252m3(r, r);
+	curve25519_ifma_mul(r, r, d3);
+	curve25519_ifma_mul(r, r, n);
+
+	curve25519_ifma_store(x, r);
+	curve25519_ifma_store(num, n);
+	curve25519_ifma_store(den, d);
+}
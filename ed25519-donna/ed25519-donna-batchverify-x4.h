@@ -0,0 +1,195 @@
+/*
+	4-way SIMD backends for batch verification
+
+	A backend works on four field elements at once, limb i of each in the
+	four lanes of v[i]: the four coordinates of one point in the Bos-Coster
+	additions, four points during decompression. Points are converted into
+	lanes once after decompression and back once for the final scalar
+	multiplication, everything else uses the scalar field code. The backend
+	is picked at run time, the last one in the table the CPU supports.
+*/
+
+/* the loops over limbs work on registers and only stay there unrolled */
+#define ED25519_X4_UNROLL _Pragma("GCC unroll 16")
+
+typedef struct bignum25519x4_t {
+	uint64_t ALIGN(32) v[10][4];
+} bignum25519x4;
+
+typedef struct ed25519_batch_backend_t {
+	const char *name;
+	size_t limbs;
+	const unsigned char *shift; /* bit offset of each limb */
+	/* r = p + q, lanes x, y, z, t; r may be p or q */
+	void (*add)(bignum25519x4 *r, const bignum25519x4 *p, const bignum25519x4 *q);
+	/* the first steps of ge25519_unpack_negative_vartime for the four y in the lanes */
+	void (*root)(bignum25519x4 *x, bignum25519x4 *num, bignum25519x4 *den, const bignum25519x4 *y);
+} ed25519_batch_backend;
+
+/* the 32 byte little-endian number in into lane of r, without the top bit */
+static void
+curve25519_x4_expand(bignum25519x4 *r, size_t lane, const unsigned char in[32], const ed25519_batch_backend *backend) {
+	uint64_t w[4] = {0}, limb;
+	size_t i, q, s, end;
+
+	for (i = 0; i < 32; i++)
+		w[i / 8] |= (uint64_t)in[i] << ((i % 8) * 8);
+	w[3] &= 0x7fffffffffffffffull;
+
+	for (i = 0; i < backend->limbs; i++) {
+		q = backend->shift[i] / 64;
+		s = backend->shift[i] % 64;
+		end = (i + 1 < backend->limbs) ? backend->shift[i + 1] : 255;
+		limb = w[q] >> s;
+		if (s && (q < 3))
+			limb |= w[q + 1] << (64 - s);
+		r->v[i][lane] = limb & (((uint64_t)1 << (end - backend->shift[i])) - 1);
+	}
+}
+
+/* add v to the 320 bit number w at word q */
+static void
+curve25519_x4_add_word(uint64_t w[5], size_t q, uint64_t v) {
+	for (; v && (q < 5); q++) {
+		w[q] += v;
+		v = (w[q] < v) ? 1 : 0;
+	}
+}
+
+/* reduce lane of a fully and contract it into a little-endian, 32-byte array */
+static void
+curve25519_x4_contract(unsigned char out[32], const bignum25519x4 *a, size_t lane, const ed25519_batch_backend *backend) {
+	uint64_t w[5] = {0}, g[4], top, c;
+	size_t i, q, s;
+
+	for (i = 0; i < backend->limbs; i++) {
+		q = backend->shift[i] / 64;
+		s = backend->shift[i] % 64;
+		curve25519_x4_add_word(w, q, a->v[i][lane] << s);
+		if (s)
+			curve25519_x4_add_word(w, q + 1, a->v[i][lane] >> (64 - s));
+	}
+
+	/* fold everything from bit 255 up back in with 2^255 = 19, twice */
+	for (i = 0; i < 2; i++) {
+		top = (w[3] >> 63) | (w[4] << 1);
+		w[3] &= 0x7fffffffffffffffull;
+		w[4] = 0;
+		curve25519_x4_add_word(w, 0, top * 19);
+	}
+
+	/* w is below 2^255 now, subtract p if w + 19 reaches 2^255 */
+	c = 19;
+	for (i = 0; i < 4; i++) {
+		g[i] = w[i] + c;
+		c = (g[i] < c) ? 1 : 0;
+	}
+	if (g[3] >> 63) {
+		g[3] &= 0x7fffffffffffffffull;
+		for (i = 0; i < 4; i++)
+			w[i] = g[i];
+	}
+
+	for (i = 0; i < 32; i++)
+		out[i] = (unsigned char)(w[i / 8] >> ((i % 8) * 8));
+}
+
+static void
+ge25519_x4_load(bignum25519x4 *r, const ge25519 *p, const ed25519_batch_backend *backend) {
+	unsigned char b[32];
+	curve25519_contract(b, p->x); curve25519_x4_expand(r, 0, b, backend);
+	curve25519_contract(b, p->y); curve25519_x4_expand(r, 1, b, backend);
+	curve25519_contract(b, p->z); curve25519_x4_expand(r, 2, b, backend);
+	curve25519_contract(b, p->t); curve25519_x4_expand(r, 3, b, backend);
+}
+
+static void
+ge25519_x4_store(ge25519 *r, const bignum25519x4 *p, const ed25519_batch_backend *backend) {
+	unsigned char b[32];
+	curve25519_x4_contract(b, p, 0, backend); curve25519_expand(r->x, b);
+	curve25519_x4_contract(b, p, 1, backend); curve25519_expand(r->y, b);
+	curve25519_x4_contract(b, p, 2, backend); curve25519_expand(r->z, b);
+	curve25519_x4_contract(b, p, 3, backend); curve25519_expand(r->t, b);
+}
+
+/* decompress the four points p, bit k of the result is set if p[k] is valid */
+static int
+ge25519_unpack_negative_vartime_x4(ge25519 *r[4], const unsigned char *p[4], const ed25519_batch_backend *backend) {
+	static const bignum25519 one = {1};
+	bignum25519x4 ALIGN(32) y, x, num, den;
+	bignum25519 n, d;
+	unsigned char b[32];
+	size_t k;
+	int valid = 0;
+
+	for (k = 0; k < 4; k++)
+		curve25519_x4_expand(&y, k, p[k], backend);
+	backend->root(&x, &num, &den, &y);
+
+	for (k = 0; k < 4; k++) {
+		curve25519_expand(r[k]->y, p[k]);
+		curve25519_copy(r[k]->z, one);
+		curve25519_x4_contract(b, &x, k, backend); curve25519_expand(r[k]->x, b);
+		curve25519_x4_contract(b, &num, k, backend); curve25519_expand(n, b);
+		curve25519_x4_contract(b, &den, k, backend); curve25519_expand(d, b);
+		if (ge25519_unpack_negative_vartime_finish(r[k], n, d, p[k][31] >> 7))
+			valid |= 1 << k;
+	}
+	return valid;
+}
+
+#include "ed25519-donna-batchverify-avx2.h"
+#include "ed25519-donna-batchverify-ifma.h"
+
+static const unsigned char ed25519_batch_shift_25[10] = {0, 26, 51, 77, 102, 128, 153, 179, 204, 230};
+static const unsigned char ed25519_batch_shift_51[5] = {0, 51, 102, 153, 204};
+
+/* slowest first, each one needs the CPU features of the ones before it */
+static const ed25519_batch_backend ed25519_batch_backends[] = {
+	{"ref", 0, NULL, NULL, NULL},
+	{"avx2", 10, ed25519_batch_shift_25, ge25519_add_avx2, ge25519_root_avx2},
+	{"avx512ifma", 5, ed25519_batch_shift_51, ge25519_add_ifma, ge25519_root_ifma}
+};
+
+#define ED25519_BATCH_BACKEND_COUNT (sizeof(ed25519_batch_backends) / sizeof(ed25519_batch_backends[0]))
+
+static int
+ed25519_batch_supported(const ed25519_batch_backend *backend) {
+	__builtin_cpu_init();
+	if (backend->add == ge25519_add_avx2)
+		return __builtin_cpu_supports("avx2");
+	if (backend->add == ge25519_add_ifma)
+		return __builtin_cpu_supports("avx512ifma") && __builtin_cpu_supports("avx512vl");
+	return 1;
+}
+
+static const ed25519_batch_backend *ed25519_batch_selected = NULL;
+
+static const ed25519_batch_backend *
+ed25519_batch_backend_get(void) {
+	size_t n;
+
+	/* a race on the first call picks the same backend twice */
+	if (ed25519_batch_selected == NULL) {
+		n = 1;
+		while ((n < ED25519_BATCH_BACKEND_COUNT) && ed25519_batch_supported(&ed25519_batch_backends[n]))
+			n++;
+		ed25519_batch_selected = &ed25519_batch_backends[n - 1];
+	}
+	return ed25519_batch_selected;
+}
+
+static int
+ed25519_batch_backend_set(const char *name) {
+	size_t i;
+
+	for (i = 0; i < ED25519_BATCH_BACKEND_COUNT; i++) {
+		if (strcmp(ed25519_batch_backends[i].name, name) != 0)
+			continue;
+		if (!ed25519_batch_supported(&ed25519_batch_backends[i]))
+			return -1;
+		ed25519_batch_selected = &ed25519_batch_backends[i];
+		return 0;
+	}
+	return -1;
+}
@@ -10,12 +10,20 @@ static const size_t limb128bits = (128 + bignum256modm_bits_per_limb - 1) / bign
 
 typedef size_t heap_index_t;
 
+#if defined(ED25519_BATCH_X4)
+	#include "ed25519-donna-batchverify-x4.h"
+#endif
+
 typedef struct batch_heap_t {
 	unsigned char r[heap_batch_size][16]; /* 128 bit random values */
 	ge25519 points[heap_batch_size];
 	bignum256modm scalars[heap_batch_size];
 	heap_index_t heap[heap_batch_size];
 	size_t size;
+#if defined(ED25519_BATCH_X4)
+	const ed25519_batch_backend *backend; /* no add for the scalar code */
+	bignum25519x4 points4[heap_batch_size]; /* the points in lanes for backend->add */
+#endif
 } batch_heap;
 
 /* swap two values in the heap */
@@ -180,16 +188,59 @@ ge25519_multi_scalarmult_vartime(ge25519 *r, batch_heap *heap, size_t count) {
 		}
 
 		sub256_modm_batch(heap->scalars[max1], heap->scalars[max1], heap->scalars[max2], limbsize);
+#if defined(ED25519_BATCH_X4)
+		if (heap->backend->add)
+			heap->backend->add(&heap->points4[max2], &heap->points4[max2], &heap->points4[max1]);
+		else
+#endif
 		ge25519_add(&heap->points[max2], &heap->points[max2], &heap->points[max1]);
 		heap_updated_root(heap, limbsize);
 	}
 
+#if defined(ED25519_BATCH_X4)
+	if (heap->backend->add)
+		ge25519_x4_store(&heap->points[max1], &heap->points4[max1], heap->backend);
+#endif
 	ge25519_multi_scalarmult_vartime_final(r, &heap->points[max1], heap->scalars[max1]);
 }
 
 /* not actually used for anything other than testing */
 unsigned char batch_point_buffer[3][32];
 
+/* decompress the public keys into points[1..count] and the R of the signatures into points[count+1..2*count] */
+static int
+ge25519_unpack_batch_vartime(batch_heap *heap, const unsigned char **pk, const unsigned char **RS, size_t count) {
+	size_t i = 0;
+
+#if defined(ED25519_BATCH_X4)
+	ge25519 *r[4];
+	const unsigned char *p[4];
+	size_t k;
+
+	if (heap->backend->root) {
+		for (; i + 4 <= count * 2; i += 4) {
+			for (k = 0; k < 4; k++) {
+				r[k] = &heap->points[i + k + 1];
+				p[k] = (i + k < count) ? pk[i + k] : RS[i + k - count];
+			}
+			if (ge25519_unpack_negative_vartime_x4(r, p, heap->backend) != 0xf)
+				return 0;
+		}
+	}
+#endif
+
+	for (; i < count * 2; i++)
+		if (!ge25519_unpack_negative_vartime(&heap->points[i + 1], (i < count) ? pk[i] : RS[i - count]))
+			return 0;
+
+#if defined(ED25519_BATCH_X4)
+	if (heap->backend->add)
+		for (i = 0; i <= count * 2; i++)
+			ge25519_x4_load(&heap->points4[i], &heap->points[i], heap->backend);
+#endif
+	return 1;
+}
+
 static int
 ge25519_is_neutral_vartime(const ge25519 *p) {
 	static const unsigned char zero[32] = {0};
@@ -213,11 +264,20 @@ ED25519_FN(ed25519_sign_open_batch) (const unsigned char **m, size_t *mlen, cons
 	for (i = 0; i < num; i++)
 		valid[i] = 1;
 
+#if defined(ED25519_BATCH_X4)
+	batch.backend = ed25519_batch_backend_get();
+#endif
+
 	while (num > 3) {
 		batchsize = (num > max_batch_size) ? max_batch_size : num;
 
 		/* generate r (scalars[batchsize+1]..scalars[2*batchsize] */
+#if defined(ED25519_RANDOMBYTES_CHECKED)
+		if (ed25519_randombytes_checked(batch.r, batchsize * 16) != 0)
+			goto fallback;
+#else
 		ED25519_FN(ed25519_randombytes_unsafe) (batch.r, batchsize * 16);
+#endif
 		r_scalars = &batch.scalars[batchsize + 1];
 		for (i = 0; i < batchsize; i++)
 			expand256_modm(r_scalars[i], batch.r[i], 16);
@@ -239,12 +299,8 @@ ED25519_FN(ed25519_sign_open_batch) (const unsigned char **m, size_t *mlen, cons
 
 		/* compute points */
 		batch.points[0] = ge25519_basepoint;
-		for (i = 0; i < batchsize; i++)
-			if (!ge25519_unpack_negative_vartime(&batch.points[i+1], pk[i]))
-				goto fallback;
-		for (i = 0; i < batchsize; i++)
-			if (!ge25519_unpack_negative_vartime(&batch.points[batchsize+i+1], RS[i]))
-				goto fallback;
+		if (!ge25519_unpack_batch_vartime(&batch, pk, RS, batchsize))
+			goto fallback;
 
 		ge25519_multi_scalarmult_vartime(&p, &batch, (batchsize * 2) + 1);
 		if (!ge25519_is_neutral_vartime(&p)) {
@@ -273,3 +329,20 @@ ED25519_FN(ed25519_sign_open_batch) (const unsigned char **m, size_t *mlen, cons
 	return ret;
 }
 
+int
+ED25519_FN(ed25519_batch_set_backend) (const char *name) {
+#if defined(ED25519_BATCH_X4)
+	return ed25519_batch_backend_set(name);
+#else
+	return (strcmp(name, "ref") == 0) ? 0 : -1;
+#endif
+}
+
+const char *
+ED25519_FN(ed25519_batch_get_backend) (void) {
+#if defined(ED25519_BATCH_X4)
+	return ed25519_batch_backend_get()->name;
+#else
+	return "ref";
+#endif
+}
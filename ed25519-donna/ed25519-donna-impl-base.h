@@ -188,13 +188,40 @@ ge25519_pack(unsigned char r[32], const ge25519 *p) {
 	r[31] ^= ((parity[0] & 1) << 7);
 }
 
+/* r->x = num * den^3 * (num*den^7)^((p-5)/8), pick the root of num/den with the right sign */
 static int
-ge25519_unpack_negative_vartime(ge25519 *r, const unsigned char p[32]) {
+ge25519_unpack_negative_vartime_finish(ge25519 *r, const bignum25519 num, const bignum25519 den, unsigned char parity) {
 	static const unsigned char zero[32] = {0};
+	unsigned char check[32];
+	bignum25519 t, root;
+
+	/* 3. Check if either of the roots works: */
+	curve25519_square(t, r->x);
+	curve25519_mul(t, t, den);
+	curve25519_sub_reduce(root, t, num);
+	curve25519_contract(check, root);
+	if (!ed25519_verify(check, zero, 32)) {
+		curve25519_add_reduce(t, t, num);
+		curve25519_contract(check, t);
+		if (!ed25519_verify(check, zero, 32))
+			return 0;
+		curve25519_mul(r->x, r->x, ge25519_sqrtneg1);
+	}
+
+	curve25519_contract(check, r->x);
+	if ((check[0] & 1) == parity) {
+		curve25519_copy(t, r->x);
+		curve25519_neg(r->x, t);
+	}
+	curve25519_mul(r->t, r->x, r->y);
+	return 1;
+}
+
+static int
+ge25519_unpack_negative_vartime(ge25519 *r, const unsigned char p[32]) {
 	static const bignum25519 one = {1};
 	unsigned char parity = p[31] >> 7;
-	unsigned char check[32];
-	bignum25519 t, root, num, den, d3;
+	bignum25519 t, num, den, d3;
 
 	curve25519_expand(r->y, p);
 	curve25519_copy(r->z, one);
@@ -216,26 +243,7 @@ ge25519_unpack_negative_vartime(ge25519 *r, const unsigned char p[32]) {
 	curve25519_mul(r->x, r->x, d3);
 	curve25519_mul(r->x, r->x, num);
 
-	/* 3. Check if either of the roots works: */
-	curve25519_square(t, r->x);
-	curve25519_mul(t, t, den);
-	curve25519_sub_reduce(root, t, num);
-	curve25519_contract(check, root);
-	if (!ed25519_verify(check, zero, 32)) {
-		curve25519_add_reduce(t, t, num);
-		curve25519_contract(check, t);
-		if (!ed25519_verify(check, zero, 32))
-			return 0;
-		curve25519_mul(r->x, r->x, ge25519_sqrtneg1);
-	}
-
-	curve25519_contract(check, r->x);
-	if ((check[0] & 1) == parity) {
-		curve25519_copy(t, r->x);
-		curve25519_neg(r->x, t);
-	}
-	curve25519_mul(r->t, r->x, r->y);
-	return 1;
+	return ge25519_unpack_negative_vartime_finish(r, num, den, parity);
 }
 
 
@@ -11,7 +11,13 @@
 
 #include "ed25519-donna-portable.h"
 
+#if !defined(ED25519_SSE2) && !defined(ED25519_FORCE_32BIT) && defined(__ARM_ARCH_7EM__)
+	#define ED25519_CORTEXM4
+#endif
+
 #if defined(ED25519_SSE2)
+#elif defined(ED25519_CORTEXM4)
+	#define ED25519_32BIT
 #else
 	#if defined(HAVE_UINT128) && !defined(ED25519_FORCE_32BIT)
 		#define ED25519_64BIT
@@ -41,8 +47,15 @@
 	#endif
 #endif
 
+/* 4-way AVX2 and AVX-512 IFMA field code for batch verification, picked at run time */
+#if defined(CPU_X86_64) && defined(COMPILER_GCC) && !defined(ED25519_SSE2) && !defined(ED25519_CORTEXM4)
+	#define ED25519_BATCH_X4
+#endif
+
 #if defined(ED25519_SSE2)
 	#include "curve25519-donna-sse2.h"
+#elif defined(ED25519_CORTEXM4)
+	#include "curve25519-donna-cortexm4.h"
 #elif defined(ED25519_64BIT)
 	#include "curve25519-donna-64bit.h"
 #else
@@ -99,6 +112,8 @@ typedef struct ge25519_pniels_t {
 #if defined(ED25519_64BIT)
 	#include "ed25519-donna-64bit-tables.h"
 	#include "ed25519-donna-64bit-x86.h"
+#elif defined(ED25519_CORTEXM4)
+	#include "ed25519-donna-cortexm4-tables.h"
 #else
 	#include "ed25519-donna-32bit-tables.h"
 	#include "ed25519-donna-64bit-x86-32bit.h"
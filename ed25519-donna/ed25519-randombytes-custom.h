@@ -5,18 +5,149 @@
 
 	ed25519_randombytes_unsafe is used by the batch verification function
 	to create random scalars
+
+	it may also define ED25519_RANDOMBYTES_CHECKED and implement:
+
+	static int ed25519_randombytes_checked(void *p, size_t len);
+
+	returning -1 when no random bytes could be made, batch verification
+	then checks the signatures one at a time instead
+
+	This one is the mbedTLS CTR_DRBG, seeded from mbedtls_entropy_func,
+	which is the TRNG of the target or the OS on a host, and reseeded by
+	the DRBG itself. Bytes are handed out of a buffer that is refilled one
+	full DRBG request at a time, under a lock.
 */
 
 #include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-
-void ED25519_FN(ed25519_randombytes_unsafe) (void *p, size_t len){
-	// TODO use (T)RNG or mbed PSA
-	uint8_t num = 0;
-	srand((unsigned int)time(NULL));
-	 for (size_t l = 0; l < len; l++) {
-    num = (uint8_t)rand();
-		memcpy(p+l, &num, sizeof(uint8_t));
-  }
+#include <string.h>
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+
+#if defined(__MBED__) && defined(MBED_CONF_RTOS_PRESENT)
+	#include "mbed_rtos_storage.h"
+	#define ED25519_RANDOMBYTES_RTOS
+#elif !defined(__MBED__) && (defined(__linux__) || defined(__APPLE__))
+	#include <pthread.h>
+	#define ED25519_RANDOMBYTES_PTHREAD
+#endif
+
+#define ED25519_RANDOMBYTES_CHECKED
+#define ED25519_RANDOMBYTES_BUFFER MBEDTLS_CTR_DRBG_MAX_REQUEST
+
+typedef struct ed25519_randombytes_state_t {
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context drbg;
+	unsigned char buffer[ED25519_RANDOMBYTES_BUFFER];
+	size_t left;
+	int seeded;
+} ed25519_randombytes_state;
+
+static ed25519_randombytes_state ed25519_rng;
+
+#if defined(ED25519_RANDOMBYTES_RTOS)
+
+static mbed_rtos_storage_mutex_t ed25519_rng_mutex_storage;
+static osMutexId_t ed25519_rng_mutex = NULL;
+
+static void
+ed25519_randombytes_lock(void) {
+	const osMutexAttr_t attr = {"ed25519_rng", osMutexPrioInherit, &ed25519_rng_mutex_storage, sizeof(ed25519_rng_mutex_storage)};
+	int32_t locked;
+
+	/* the scheduler is held off so that two first callers can not both create it */
+	if (ed25519_rng_mutex == NULL) {
+		locked = osKernelLock();
+		if (ed25519_rng_mutex == NULL)
+			ed25519_rng_mutex = osMutexNew(&attr);
+		osKernelRestoreLock(locked);
+	}
+	osMutexAcquire(ed25519_rng_mutex, osWaitForever);
+}
+
+static void
+ed25519_randombytes_unlock(void) {
+	osMutexRelease(ed25519_rng_mutex);
+}
+
+#elif defined(ED25519_RANDOMBYTES_PTHREAD)
+
+static pthread_mutex_t ed25519_rng_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+ed25519_randombytes_lock(void) {
+	pthread_mutex_lock(&ed25519_rng_mutex);
+}
+
+static void
+ed25519_randombytes_unlock(void) {
+	pthread_mutex_unlock(&ed25519_rng_mutex);
+}
+
+#else
+
+/* a single thread */
+static void ed25519_randombytes_lock(void) {}
+static void ed25519_randombytes_unlock(void) {}
+
+#endif
+
+/* seed on first use and fill the buffer, the lock is held */
+static int
+ed25519_randombytes_refill(ed25519_randombytes_state *rng) {
+	static const char pers[] = "ed25519 batch";
+	int ret;
+
+	if (!rng->seeded) {
+		mbedtls_entropy_init(&rng->entropy);
+		mbedtls_ctr_drbg_init(&rng->drbg);
+		if ((ret = mbedtls_ctr_drbg_seed(&rng->drbg, mbedtls_entropy_func, &rng->entropy,
+		                                 (const unsigned char *)pers, sizeof(pers))) != 0) {
+			printf("ed25519 drbg seed failed: -0x%x\n", -ret);
+			mbedtls_ctr_drbg_free(&rng->drbg);
+			mbedtls_entropy_free(&rng->entropy);
+			return -1;
+		}
+		rng->seeded = 1;
+	}
+
+	if ((ret = mbedtls_ctr_drbg_random(&rng->drbg, rng->buffer, sizeof(rng->buffer))) != 0) {
+		printf("ed25519 drbg failed: -0x%x\n", -ret);
+		return -1;
+	}
+	rng->left = sizeof(rng->buffer);
+	return 0;
+}
+
+static int
+ed25519_randombytes_checked(void *p, size_t len) {
+	ed25519_randombytes_state *rng = &ed25519_rng;
+	unsigned char *out = (unsigned char *)p, *in;
+	size_t use;
+	int ret = 0;
+
+	ed25519_randombytes_lock();
+	while (len) {
+		if (!rng->left && (ed25519_randombytes_refill(rng) != 0)) {
+			ret = -1;
+			break;
+		}
+		use = (len > rng->left) ? rng->left : len;
+		in = rng->buffer + (sizeof(rng->buffer) - rng->left);
+		memcpy(out, in, use);
+		/* bytes handed out are not kept around */
+		memset(in, 0, use);
+
+		rng->left -= use;
+		out += use;
+		len -= use;
+	}
+	ed25519_randombytes_unlock();
+	return ret;
+}
+
+void
+ED25519_FN(ed25519_randombytes_unsafe) (void *p, size_t len) {
+	if (ed25519_randombytes_checked(p, len) != 0)
+		memset(p, 0, len);
 }
@@ -41,28 +41,32 @@ ed25519_hram(hash_512bits hram, const ed25519_signature RS, const ed25519_public
 	ed25519_hash_final(&ctx, hram);
 }
 
-void
-ED25519_FN(ed25519_publickey) (const ed25519_secret_key sk, ed25519_public_key pk) {
+/* A = aB */
+static void
+ed25519_publickey_ext(ed25519_public_key pk, const hash_512bits extsk) {
 	bignum256modm a;
 	ge25519 ALIGN(16) A;
-	hash_512bits extsk;
 
-	/* A = aB */
-	ed25519_extsk(extsk, sk);
 	expand256_modm(a, extsk, 32);
 	ge25519_scalarmult_base_niels(&A, ge25519_niels_base_multiples, a);
 	ge25519_pack(pk, &A);
 }
 
-
 void
-ED25519_FN(ed25519_sign) (const unsigned char *m, size_t mlen, const ed25519_secret_key sk, const ed25519_public_key pk, ed25519_signature RS) {
+ED25519_FN(ed25519_publickey) (const ed25519_secret_key sk, ed25519_public_key pk) {
+	hash_512bits extsk;
+
+	ed25519_extsk(extsk, sk);
+	ed25519_publickey_ext(pk, extsk);
+}
+
+
+static void
+ed25519_sign_ext(const unsigned char *m, size_t mlen, const hash_512bits extsk, const ed25519_public_key pk, ed25519_signature RS) {
 	ed25519_hash_context ctx;
 	bignum256modm r, S, a;
 	ge25519 ALIGN(16) R;
-	hash_512bits extsk, hashr, hram;
-
-	ed25519_extsk(extsk, sk);
+	hash_512bits hashr, hram;
 
 	/* r = H(aExt[32..64], m) */
 	ed25519_hash_init(&ctx);
@@ -90,6 +94,92 @@ ED25519_FN(ed25519_sign) (const unsigned char *m, size_t mlen, const ed25519_sec
 	contract256_modm(RS + 32, S);
 }
 
+void
+ED25519_FN(ed25519_sign) (const unsigned char *m, size_t mlen, const ed25519_secret_key sk, const ed25519_public_key pk, ed25519_signature RS) {
+	hash_512bits extsk;
+
+	ed25519_extsk(extsk, sk);
+	ed25519_sign_ext(m, mlen, extsk, pk, RS);
+}
+
+/*
+	Expanded keys: the hashed secret key and the public key, so that a
+	signature only costs the two message hashes and rB
+*/
+
+void
+ED25519_FN(ed25519_expand_key) (const ed25519_secret_key sk, ed25519_expanded_key *key) {
+	ed25519_extsk(key->extsk, sk);
+	ed25519_publickey_ext(key->pk, key->extsk);
+}
+
+void
+ED25519_FN(ed25519_sign_expanded) (const unsigned char *m, size_t mlen, const ed25519_expanded_key *key, ed25519_signature RS) {
+	ed25519_sign_ext(m, mlen, key->extsk, key->pk, RS);
+}
+
+void
+ED25519_FN(ed25519_sign_cache_init) (ed25519_sign_cache *cache) {
+	memset(cache, 0, sizeof(*cache));
+}
+
+/* the expanded key of sk, pk from the cache, the least recently used entry is replaced on a miss */
+static ed25519_expanded_key *
+ed25519_sign_cache_get(ed25519_sign_cache *cache, const ed25519_secret_key sk, const ed25519_public_key pk) {
+	ed25519_expanded_key key;
+	size_t i, slot = 0;
+
+	for (i = 0; i < cache->count; i++) {
+		if (memcmp(cache->key[i].pk, pk, 32) != 0)
+			continue;
+		if (!ed25519_verify(cache->sk[i], sk, 32))
+			break;
+		cache->used[i] = ++cache->clock;
+		return &cache->key[i];
+	}
+
+	ED25519_FN(ed25519_expand_key) (sk, &key);
+	if (!ed25519_verify(key.pk, pk, 32)) {
+		memset(&key, 0, sizeof(key));
+		return NULL;
+	}
+
+	if (i < cache->count) {
+		/* same public key, different secret key: the old one was wrong */
+		slot = i;
+	} else if (cache->count < ED25519_SIGN_CACHE_KEYS) {
+		slot = cache->count++;
+	} else {
+		for (i = 1; i < ED25519_SIGN_CACHE_KEYS; i++)
+			if (cache->used[i] < cache->used[slot])
+				slot = i;
+	}
+	memcpy(cache->sk[slot], sk, 32);
+	cache->key[slot] = key;
+	cache->used[slot] = ++cache->clock;
+	memset(&key, 0, sizeof(key));
+	return &cache->key[slot];
+}
+
+int
+ED25519_FN(ed25519_sign_cached) (ed25519_sign_cache *cache, const unsigned char *m, size_t mlen, const ed25519_secret_key sk, const ed25519_public_key pk, ed25519_signature RS) {
+	ed25519_expanded_key *key = ed25519_sign_cache_get(cache, sk, pk);
+
+	if (!key)
+		return -1;
+	ED25519_FN(ed25519_sign_expanded) (m, mlen, key, RS);
+	return 0;
+}
+
+void
+ED25519_FN(ed25519_sign_cache_clear) (ed25519_sign_cache *cache) {
+	volatile unsigned char *p = (volatile unsigned char *)cache;
+	size_t i;
+
+	for (i = 0; i < sizeof(*cache); i++)
+		p[i] = 0;
+}
+
 int
 ED25519_FN(ed25519_sign_open) (const unsigned char *m, size_t mlen, const ed25519_public_key pk, const ed25519_signature RS) {
 	ge25519 ALIGN(16) R, A;
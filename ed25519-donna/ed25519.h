@@ -17,8 +17,39 @@ void ed25519_publickey(const ed25519_secret_key sk, ed25519_public_key pk);
 int ed25519_sign_open(const unsigned char *m, size_t mlen, const ed25519_public_key pk, const ed25519_signature RS);
 void ed25519_sign(const unsigned char *m, size_t mlen, const ed25519_secret_key sk, const ed25519_public_key pk, ed25519_signature RS);
 
+/* the hashed secret key and the public key, expanded once and signed with many times */
+typedef struct ed25519_expanded_key_t {
+	unsigned char extsk[64];
+	ed25519_public_key pk;
+} ed25519_expanded_key;
+
+void ed25519_expand_key(const ed25519_secret_key sk, ed25519_expanded_key *key);
+void ed25519_sign_expanded(const unsigned char *m, size_t mlen, const ed25519_expanded_key *key, ed25519_signature RS);
+
+/* expanded keys by public key, least recently used replaced; one per thread or behind a lock */
+#if !defined(ED25519_SIGN_CACHE_KEYS)
+#define ED25519_SIGN_CACHE_KEYS 4
+#endif
+
+typedef struct ed25519_sign_cache_t {
+	ed25519_secret_key sk[ED25519_SIGN_CACHE_KEYS];
+	ed25519_expanded_key key[ED25519_SIGN_CACHE_KEYS];
+	unsigned long used[ED25519_SIGN_CACHE_KEYS];
+	unsigned long clock;
+	size_t count;
+} ed25519_sign_cache;
+
+void ed25519_sign_cache_init(ed25519_sign_cache *cache);
+int ed25519_sign_cached(ed25519_sign_cache *cache, const unsigned char *m, size_t mlen, const ed25519_secret_key sk, const ed25519_public_key pk, ed25519_signature RS); /* -1 if pk is not the key of sk */
+void ed25519_sign_cache_clear(ed25519_sign_cache *cache); /* wipes the secret keys */
+
+/* keeps a batch of 64 on the stack, about 28 KB with 32 bit limbs and 24 KB with the Cortex-M4 field code, more than the main thread of a target has */
 int ed25519_sign_open_batch(const unsigned char **m, size_t *mlen, const unsigned char **pk, const unsigned char **RS, size_t num, int *valid);
 
+/* SIMD field code for ed25519_sign_open_batch: "ref", "avx2" or "avx512ifma", the fastest one the CPU supports by default */
+int ed25519_batch_set_backend(const char *name); /* -1 if unknown or not supported by the CPU */
+const char *ed25519_batch_get_backend(void);
+
 void ed25519_randombytes_unsafe(void *out, size_t count);
 
 void curved25519_scalarmult_basepoint(curved25519_key pk, const curved25519_key e);
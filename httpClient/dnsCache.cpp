@@ -0,0 +1,117 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Resolved address cache with TTL
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dnsCache.h"
+
+dnsCache::dnsCache(dns_resolver_t resolver, void *ctx, dns_clock_t clock,
+                   uint32_t ttl_ms, uint32_t negative_ttl_ms)
+    : _resolver(resolver), _ctx(ctx), _clock(clock), _ttl(ttl_ms),
+      _negative_ttl(negative_ttl_ms), _use_count(0) {
+  memset(&_stats, 0, sizeof(_stats));
+  flush();
+}
+
+void dnsCache::flush() {
+  for (size_t i = 0; i < DNS_CACHE_SIZE; i++) {
+    _entries[i].host.clear();
+    _entries[i].addr[0] = '\0';
+    _entries[i].expires = 0;
+    _entries[i].retry_after = 0;
+    _entries[i].error = 0;
+    _entries[i].last_used = 0;
+  }
+}
+
+dnsCache::dns_entry_t *dnsCache::find(const char *host) {
+  for (size_t i = 0; i < DNS_CACHE_SIZE; i++) {
+    if (_entries[i].last_used != 0 && _entries[i].host == host) {
+      return &_entries[i];
+    }
+  }
+  return NULL;
+}
+
+dnsCache::dns_entry_t *dnsCache::evict(const char *host) {
+  // replace the least recently used entry
+  dns_entry_t *entry = &_entries[0];
+  for (size_t i = 1; i < DNS_CACHE_SIZE; i++) {
+    if (_entries[i].last_used < entry->last_used) {
+      entry = &_entries[i];
+    }
+  }
+  entry->host = host;
+  entry->addr[0] = '\0';
+  entry->expires = 0;
+  entry->retry_after = 0;
+  entry->error = 0;
+  return entry;
+}
+
+int dnsCache::copy_addr(const dns_entry_t *entry, char *addr,
+                        size_t addr_len) {
+  size_t len = strlen(entry->addr);
+  if (len + 1 > addr_len) {
+    return -1;
+  }
+  memcpy(addr, entry->addr, len + 1);
+  return 0;
+}
+
+int dnsCache::lookup(const char *host, char *addr, size_t addr_len) {
+  if (!host || !addr || addr_len == 0) {
+    printf("[%s:%d] invalid parameters\n", __func__, __LINE__);
+    return -1;
+  }
+
+  uint64_t now = _clock();
+  dns_entry_t *entry = find(host);
+  if (!entry) {
+    entry = evict(host);
+  }
+  entry->last_used = ++_use_count;
+
+  if (entry->addr[0] != '\0' && now < entry->expires) {
+    _stats.hits++;
+    return copy_addr(entry, addr, addr_len);
+  }
+
+  if (now < entry->retry_after) {
+    // the resolver failed recently, do not ask again yet
+    if (entry->addr[0] != '\0') {
+      _stats.stale++;
+      return copy_addr(entry, addr, addr_len);
+    }
+    _stats.negative_hits++;
+    return entry->error;
+  }
+
+  char resolved[DNS_ADDR_LEN] = {};
+  int ret = _resolver(_ctx, host, resolved, sizeof(resolved));
+  if (ret == 0 && resolved[0] != '\0') {
+    _stats.misses++;
+    memcpy(entry->addr, resolved, sizeof(entry->addr));
+    entry->expires = now + _ttl;
+    entry->retry_after = 0;
+    entry->error = 0;
+    return copy_addr(entry, addr, addr_len);
+  }
+
+  _stats.failures++;
+  entry->error = ret != 0 ? ret : -1;
+  entry->retry_after = now + _negative_ttl;
+  if (entry->addr[0] != '\0') {
+    // fall back to the last known good address
+    _stats.stale++;
+    return copy_addr(entry, addr, addr_len);
+  }
+  return entry->error;
+}
@@ -0,0 +1,86 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Resolved address cache with TTL
+ *
+ * Keeps resolved addresses for a fixed TTL and failed lookups for a shorter
+ * negative TTL. When the resolver fails, the last known good address is
+ * returned instead. The resolver and the clock are plain callbacks without
+ * Mbed OS dependencies, so the cache also builds on a host against a stub
+ * resolver.
+ */
+
+#ifndef __DNS_CACHE_H__
+#define __DNS_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#ifndef DNS_CACHE_SIZE
+#define DNS_CACHE_SIZE 4
+#endif
+
+#define DNS_ADDR_LEN 48 // enough for an IPv6 address string
+
+/**
+ * @brief Resolve a hostname into an IP address string
+ *
+ * @return int 0 on success
+ */
+typedef int (*dns_resolver_t)(void *ctx, const char *host, char *addr,
+                              size_t addr_len);
+typedef uint64_t (*dns_clock_t)(void); // monotonic time in milliseconds
+
+typedef struct {
+  uint32_t hits;          // answered from a fresh entry
+  uint32_t misses;        // answered by the resolver
+  uint32_t negative_hits; // failed without asking the resolver again
+  uint32_t stale;         // last known good address after a failure
+  uint32_t failures;      // resolver errors
+} dns_stats_t;
+
+class dnsCache {
+public:
+  dnsCache(dns_resolver_t resolver, void *ctx, dns_clock_t clock,
+           uint32_t ttl_ms, uint32_t negative_ttl_ms);
+
+  /**
+   * @brief Get the address of a host from the cache or the resolver
+   *
+   * @param[in] host The hostname
+   * @param[out] addr The IP address string
+   * @param[in] addr_len The size of addr
+   * @return int 0 on success, the resolver error otherwise
+   */
+  int lookup(const char *host, char *addr, size_t addr_len);
+  void flush();
+  const dns_stats_t &stats() { return _stats; }
+
+private:
+  typedef struct {
+    std::string host;
+    char addr[DNS_ADDR_LEN]; // last known good address, empty if none
+    uint64_t expires;        // the address is fresh until
+    uint64_t retry_after;    // negative entry, do not resolve before
+    int error;               // last resolver error
+    uint64_t last_used;
+  } dns_entry_t;
+
+  dns_entry_t *find(const char *host);
+  dns_entry_t *evict(const char *host);
+  int copy_addr(const dns_entry_t *entry, char *addr, size_t addr_len);
+
+  dns_resolver_t _resolver;
+  void *_ctx;
+  dns_clock_t _clock;
+  uint32_t _ttl;
+  uint32_t _negative_ttl;
+  dns_entry_t _entries[DNS_CACHE_SIZE];
+  uint64_t _use_count;
+  dns_stats_t _stats;
+};
+
+#endif
@@ -8,73 +8,252 @@
  */
 
 #include "httpClient.h"
-#include "root_ca_cert.h"
+#include "httpWriter.h"
 
 // #define HTTP_DEBUG
 
-http_data_t httpClient::response;
-http_state_t httpClient::http_st;
+// parser callbacks reach their client through llhttp_t::data
 
 int httpClient::on_message_begin(llhttp_t *parser) { return 0; }
 
 int httpClient::on_headers_complete(llhttp_t *parser) {
-  response.status_code = parser->status_code;
-  response.content_length = parser->content_length;
-  response.processed_data = 0;
-  http_st = HTTP_ST_RES_HEADER_COMPLETE;
+  httpClient *client = static_cast<httpClient *>(parser->data);
+  client->response.status_code = parser->status_code;
+  client->response.content_length = parser->content_length;
+  client->response.processed_data = 0;
+  client->http_st = HTTP_ST_RES_HEADER_COMPLETE;
+  if (client->_latency_ms < 0) {
+    client->_latency_ms = clock_ms() - client->_sent_at;
+  }
   return 0;
 }
 
 int httpClient::on_body(llhttp_t *parser, char const *at, size_t length) {
-  response.buffer.append(at, length);
-  response.processed_data += length;
+  httpClient *client = static_cast<httpClient *>(parser->data);
+  client->response.processed_data += length;
+  unsigned int status = client->response.status_code;
+  if (client->_sink && status >= 200 && status < 300) {
+    // error responses stay in response_data()
+    // hand the chunk over without buffering it
+    return client->_sink(client->_sink_ctx, at, length) == 0 ? 0 : -1;
+  }
+  client->response.buffer.append(at, length);
   return 0;
 }
 
-int httpClient::socket_prepare() {
-  nsapi_size_or_error_t ret = 0;
+int httpClient::on_chunk_header(llhttp_t *parser) {
+  httpClient *client = static_cast<httpClient *>(parser->data);
+  client->_stats.chunks++;
+  return 0;
+}
 
-  _wifi = WiFiInterface::get_default_instance();
-  if (!_wifi) {
-    printf("unable to get wifi interface\n");
-    return -1;
+int httpClient::on_message_complete(llhttp_t *parser) {
+  httpClient *client = static_cast<httpClient *>(parser->data);
+  client->http_st = HTTP_ST_RES_DATA_COMPLETE;
+  if (client->_pipeline_results &&
+      client->_pipeline_next < client->_pipeline_end) {
+    // hand the response to its request, the parser goes on with the next one
+    http_result_t &res = (*client->_pipeline_results)[client->_pipeline_next++];
+    res.ret = client->response.processed_data;
+    res.status_code = client->response.status_code;
+    res.body.swap(client->response.buffer);
+    client->response.buffer.clear();
+    client->response.processed_data = 0;
   }
+  return 0;
+}
 
-  // socket open
-  if ((ret = _tls->open(_wifi)) != NSAPI_ERROR_OK) {
-    printf("TLS socket open failed: %d\n", ret);
+int httpClient::resolve_host(void *ctx, const char *host, char *addr,
+                             size_t addr_len) {
+  httpClient *client = static_cast<httpClient *>(ctx);
+  SocketAddress sock_addr;
+  nsapi_error_t ret = client->_wifi->gethostbyname(host, &sock_addr);
+  if (ret != NSAPI_ERROR_OK) {
+    printf("get address by hostname failed: %d\n", ret);
     return ret;
   }
+  if (!sock_addr.get_ip_address()) {
+    return NSAPI_ERROR_DNS_FAILURE;
+  }
+  snprintf(addr, addr_len, "%s", sock_addr.get_ip_address());
+  return 0;
+}
+
+uint64_t httpClient::clock_ms() {
+  return Kernel::Clock::now().time_since_epoch().count();
+}
+
+tlsTransport *httpClient::transport() {
+  if (!_tls) {
+    // kept across connections for its TLS configuration
+    _tls = new tlsTransport();
+    if (!_tls) {
+      printf("new socket failed\n");
+    }
+  }
+  return _tls;
+}
+
+int httpClient::phase_timeout(uint32_t phase_ms) {
+  uint64_t now = clock_ms();
+  uint64_t left = now < _deadline ? _deadline - now : 0;
+  _deadline_bound = left <= phase_ms;
+  return _deadline_bound ? left : phase_ms;
+}
+
+void httpClient::count_failure(uint32_t &counter, int err) {
+  if (err == NSAPI_ERROR_TIMEOUT && _deadline_bound) {
+    _stats.total_timeouts++;
+  } else {
+    counter++;
+  }
+  _net_error = true;
+}
+
+bool httpClient::server_error() {
+  return http_st >= HTTP_ST_RES_HEADER_COMPLETE &&
+         (response.status_code >= 500 || response.status_code == 429);
+}
+
+bool httpClient::retryable(llhttp_method_t method, int ret) {
+  if (http_st >= HTTP_ST_RES_HEADER_COMPLETE) {
+    // the node answered, repeat only what it did not process
+    unsigned int code = response.status_code;
+    return code == 429 || code == 503 || (method == HTTP_GET && code >= 500);
+  }
+  if (ret >= 0 || !_net_error) {
+    return false;
+  }
+  // a complete POST may have been processed even though no response came back
+  return method == HTTP_GET || http_st < HTTP_ST_REQ_DATA_COMPLETE;
+}
+
+bool httpClient::retry_delay(llhttp_method_t method, int ret, unsigned attempt,
+                             uint32_t *delay_ms) {
+  uint32_t rnd = 0;
+  if (attempt >= _retry.retries || !retryable(method, ret)) {
+    return false;
+  }
+  // seeded from the device entropy, clients do not retry in lockstep
+  if (!transport() || _tls->random(&rnd, sizeof(rnd)) != 0) {
+    rnd = (uint32_t)clock_ms();
+  }
+  *delay_ms = http_backoff_ms(&_retry, attempt, rnd);
+  if (_nodes.select() != _node) {
+    // another node can take the request right away
+    _stats.failovers++;
+    *delay_ms = 0;
+  }
+  // give up rather than wait past the deadline
+  return clock_ms() + *delay_ms < _deadline;
+}
 
-  // set root ca
-  if ((ret = _tls->set_root_ca_cert(root_ca_pem)) != NSAPI_ERROR_OK) {
-    printf("TLS set CA failed: %d\n", ret);
+void httpClient::node_report(bool ok) {
+  _nodes.report(_node, ok, _latency_ms);
+}
+
+nsapi_size_or_error_t httpClient::recv_timed(uint32_t phase_ms,
+                                             uint32_t &timeout_counter) {
+  nsapi_size_or_error_t ret = 0;
+  if (_canned) {
+    // a canned response in reads of at most _canned_read bytes, then the
+    // end of the connection
+    if (_canned_len == 0) {
+      return tlsTransport::read_result(_canned_end, true);
+    }
+    ret = min(min(_canned_len, _canned_read), (size_t)HTTP_BUF_SIZE);
+    memcpy(io_buf, _canned, ret);
+    _canned += ret;
+    _canned_len -= ret;
     return ret;
   }
-  _tls->set_hostname(IOTA_NODE_HOST);
+  _tls->set_timeout(phase_timeout(phase_ms));
+  ret = _tls->recv(io_buf, HTTP_BUF_SIZE);
+  if (ret > 0) {
+    _stats.rx_bytes += ret;
+  } else if (ret == NSAPI_ERROR_TIMEOUT) {
+    count_failure(timeout_counter, ret);
+  } else if (ret < 0) {
+    count_failure(_stats.recv_failures, ret);
+  }
+  return ret;
+}
+
+int httpClient::socket_connect() {
+  nsapi_size_or_error_t ret = 0;
+
+  _wifi = WiFiInterface::get_default_instance();
+  if (!_wifi) {
+    printf("unable to get wifi interface\n");
+    return -1;
+  }
 
-  SocketAddress addr;
-  // hostname
-  if ((ret = _wifi->gethostbyname(IOTA_NODE_HOST, &addr)) != NSAPI_ERROR_OK) {
+  const node_info_t &node = _nodes.node(_node);
+
+  // hostname, from the cache unless expired
+  char ip[DNS_ADDR_LEN] = {};
+  if ((ret = _dns.lookup(node.host.c_str(), ip, sizeof(ip))) !=
+      NSAPI_ERROR_OK) {
     printf("get address by hostname failed: %d\n", ret);
+    count_failure(_stats.dns_failures, ret);
     return ret;
   }
+  SocketAddress addr(ip);
 
 #ifdef HTTP_DEBUG
-  printf("%s address is %s\r\n", IOTA_NODE_HOST,
+  printf("%s address is %s\r\n", node.host.c_str(),
          (addr.get_ip_address() ? addr.get_ip_address() : "None"));
 #endif
   // set port number
-  addr.set_port(IOTA_NODE_PORT);
-
-  // overwrite ssl veryfy to optional
-  mbedtls_ssl_config *ssl_conf = _tls->get_ssl_config();
-  ssl_conf->authmode = MBEDTLS_SSL_VERIFY_OPTIONAL;
+  addr.set_port(node.port);
 
-  if ((ret = _tls->connect(addr)) != NSAPI_ERROR_OK) {
+#if TLS_SESSION_RESUME
+  tlsSessionCache *session_cache = &tlsSessionCache::shared();
+#else
+  tlsSessionCache *session_cache = NULL;
+#endif
+  if (!transport()) {
+    return -1;
+  }
+  if ((ret = _tls->open(_wifi, addr,
+                        phase_timeout(_timeouts.connect_ms))) != 0) {
+    count_failure(_stats.connect_failures, ret);
+    return ret;
+  }
+  if ((ret = _tls->handshake(node.host.c_str(), session_cache,
+                             phase_timeout(_timeouts.handshake_ms))) != 0) {
     printf("TLS socket connect failed: %d\n", ret);
+    count_failure(_stats.handshake_failures, ret);
     return ret;
   }
+  _conn_node = _node;
+  _stats.handshakes++;
+  if (_tls->resumed()) {
+    _stats.resumed++;
+  }
+
+  // a new connection starts a new response stream
+  llhttp_reset(&http_parser);
+  return ret;
+}
+
+int httpClient::socket_prepare() {
+  int ret = 0;
+
+  _node = _nodes.select();
+  if (_tls && _tls->connected() && _conn_node != _node) {
+    // the request goes to another node
+    socket_close();
+  }
+  _latency_ms = -1;
+  _reused = _tls && _tls->connected();
+  if (!_reused) {
+    if ((ret = socket_connect()) != NSAPI_ERROR_OK) {
+      return ret;
+    }
+  } else {
+    _stats.reused++;
+  }
 
   // response buffer init
   response.buffer.clear();
@@ -88,62 +267,75 @@ int httpClient::socket_prepare() {
   request.status_code = 0;
   request.processed_data = 0;
 
-  http_st = HTTP_ST_INIT;
+  http_st = HTTP_ST_CONNECTED;
   return ret;
 }
 
-int httpClient::send_header(llhttp_method_t method, const string &path,
-                            size_t data_len) {
-  string header;
-  if (method == HTTP_GET) {
-    header.append("GET " + path + " HTTP/1.1\r\n");
-  } else if (method == HTTP_POST) {
-    header.append("POST " + path + " HTTP/1.1\r\n");
-  } else {
-    // not support yet
+int httpClient::socket_close() {
+  if (_tls) {
+    _tls->close();
+  }
+  return 0;
+}
+
+int httpClient::send_all(char const *buf, size_t len) {
+  _tls->set_timeout(phase_timeout(_timeouts.total_ms));
+  while (len) {
+    nsapi_size_or_error_t bytes_sent = _tls->send(buf, len);
+    if (bytes_sent < 0) {
+      printf("socket send error: %d\n", bytes_sent);
+      count_failure(_stats.send_failures, bytes_sent);
+      return bytes_sent;
+    }
+    // every write is one TLS record as long as it fits the record size
+    _stats.writes++;
+    _stats.tx_bytes += bytes_sent;
+    buf += bytes_sent;
+    len -= bytes_sent;
+  }
+  return 0;
+}
+
+int httpClient::send_header(llhttp_method_t method, const string &path) {
+  http_head_t head = {method,       _nodes.node(_node).host.c_str(),
+                      path.c_str(), _body_type,
+                      _body_len,    _keep_alive};
+  int head_len = http_write_head(&head, io_buf, HTTP_BUF_SIZE);
+  if (head_len < 0) {
+    printf("request header too long or method not supported\n");
     return -1;
   }
-  header.append("Host: " IOTA_NODE_HOST "\r\n"
-                "Content-Type: application/json\r\n"
-                "User-Agent: IOTA CClient\r\n"
-                "Accept: */*\r\n"
-                "Content-Length: ");
-  header.append(to_string(data_len));
-  header.append("\r\n\r\n");
-  int sent_bytes = 0;
-  sent_bytes = _tls->send(header.c_str(), header.length());
-  http_st = HTTP_ST_REQ_HEADER_COMPLETE;
+
+  // coalesce as much of the body as fits into the same write
+  size_t body_len = min(_body_len, (size_t)(HTTP_BUF_SIZE - head_len));
+  memcpy(io_buf + head_len, _body, body_len);
 #ifdef HTTP_DEBUG
-  printf("header: \n%s\n", header.c_str());
+  printf("header: \n%.*s\n", head_len, io_buf);
 #endif
-  return sent_bytes;
-}
-
-int httpClient::send_data(const string &data) {
-  nsapi_size_t send_bytes = data.length();
-  if (send_bytes <= 0) {
-    // printf("no data\n");
-    return 0;
+  int ret = send_all(io_buf, head_len + body_len);
+  if (ret < 0) {
+    return ret;
   }
-  nsapi_size_or_error_t bytes_sent = 0;
-  while (send_bytes) {
-    bytes_sent = _tls->send(data.c_str() + bytes_sent, send_bytes);
+  http_st = HTTP_ST_REQ_HEADER_COMPLETE;
+  return body_len;
+}
 
-    if (bytes_sent < 0) {
-      printf("socket send error: %d\n", bytes_sent);
-      return -1;
+int httpClient::send_data(size_t offset) {
+  if (offset < _body_len) {
+    int ret = send_all(_body + offset, _body_len - offset);
+    if (ret < 0) {
+      return ret;
     }
-    send_bytes -= bytes_sent;
   }
   http_st = HTTP_ST_REQ_DATA_COMPLETE;
+  _sent_at = clock_ms();
 #ifdef HTTP_DEBUG
-  printf("sent: %s\n", data.c_str());
+  printf("sent: %u bytes\n", (unsigned)_body_len);
 #endif
   return 0;
 }
 
 int httpClient::fetch_response_header() {
-  memset(recv_buf, 0, HTTP_BUF_SIZE);
   int received_bytes = 0;
   if (http_st < HTTP_ST_REQ_HEADER_COMPLETE) {
     printf("respnse header state error\n");
@@ -154,91 +346,502 @@ int httpClient::fetch_response_header() {
 
   nsapi_size_or_error_t bytes_or_err = 0;
   while (http_st < HTTP_ST_RES_HEADER_COMPLETE) {
-    bytes_or_err = _tls->recv(recv_buf, HTTP_BUF_SIZE);
-    if (bytes_or_err < 0) {
+    // the first read waits for the node, the rest for the header to complete
+    bytes_or_err = recv_timed(received_bytes ? _timeouts.total_ms
+                                             : _timeouts.first_byte_ms,
+                              received_bytes ? _stats.total_timeouts
+                                             : _stats.first_byte_timeouts);
+    if (bytes_or_err <= 0) {
+      // zero means the server closed the connection
       printf("Error: socket recv: %d\n", bytes_or_err);
+      if (bytes_or_err == 0) {
+        count_failure(_stats.recv_failures, bytes_or_err);
+      }
+      return -1;
+    }
+    if (llhttp_execute(&http_parser, io_buf, bytes_or_err) != HPE_OK) {
+      printf("Error: http parser: %s\n", llhttp_get_error_reason(&http_parser));
       return -1;
     }
-    llhttp_execute(&http_parser, recv_buf, bytes_or_err);
     received_bytes += bytes_or_err;
   }
 #ifdef HTTP_DEBUG
-  printf("response header: \n%s\n", recv_buf);
+  printf("response header: \n%.*s\n", bytes_or_err, io_buf);
 #endif
   return response.content_length;
 }
 
 int httpClient::fetch_response_data() {
-  // char recv_buf[512] = {};
-  memset(recv_buf, 0, HTTP_BUF_SIZE);
   if (http_st < HTTP_ST_RES_HEADER_COMPLETE) {
     printf("fetch response status error!\n");
     return -1;
   }
-  nsapi_size_or_error_t bytes_or_err = _tls->recv(recv_buf, HTTP_BUF_SIZE);
-  if (bytes_or_err >= 0) {
-    llhttp_execute(&http_parser, recv_buf, bytes_or_err);
+  nsapi_size_or_error_t bytes_or_err =
+      recv_timed(_timeouts.total_ms, _stats.total_timeouts);
+  if (bytes_or_err > 0 &&
+      llhttp_execute(&http_parser, io_buf, bytes_or_err) != HPE_OK) {
+    printf("Error: http parser: %s\n", llhttp_get_error_reason(&http_parser));
+    return -1;
   }
   return bytes_or_err;
 }
 
-int httpClient::socket_send(llhttp_method_t method, const string &path,
-                            const string &data) {
-  int ret = 0;
-  http_st = HTTP_ST_UNINIT;
-  if (!_tls) {
-    _tls = new TLSSocket();
-    if (!_tls) {
-      printf("new socket failed\n");
+int httpClient::fetch_response_eof() {
+  // completes a body without Content-Length, fails on a truncated one
+  if (llhttp_finish(&http_parser) != HPE_OK ||
+      http_st < HTTP_ST_RES_DATA_COMPLETE) {
+    return -1;
+  }
+  return 0;
+}
+
+int httpClient::fetch_response_body() {
+  // read until the parser completes the message, whether it is delimited by
+  // Content-Length, chunked encoding or the server closing the connection
+  while (http_st < HTTP_ST_RES_DATA_COMPLETE) {
+    int fetched = fetch_response_data();
+    if (fetched < 0) {
+      return fetched;
+    } else if (fetched == 0 && fetch_response_eof() != 0) {
+      printf("no data or server requests close\n");
       return -1;
     }
   }
+  return response.processed_data;
+}
+
+int httpClient::send_request(llhttp_method_t method, const string &path) {
+  int ret = 0;
+  size_t body_sent = 0;
+  http_st = HTTP_ST_UNINIT;
 
   switch (http_st) {
   case HTTP_ST_UNINIT:
     if ((ret = socket_prepare()) != 0) {
       printf("socket connect error!\n");
-      goto done;
+      return ret;
     }
   case HTTP_ST_INIT:
   case HTTP_ST_CONNECTED:
-    if ((ret = send_header(method, path, data.length())) < 0) {
+    if ((ret = send_header(method, path)) < 0) {
       printf("send header failed\n");
-      goto done;
+      return ret;
     }
+    body_sent = ret;
   case HTTP_ST_REQ_HEADER_COMPLETE:
-    if ((ret = send_data(data)) < 0) {
+    if ((ret = send_data(body_sent)) < 0) {
       printf("send data failed\n");
-      goto done;
+      return ret;
     }
   case HTTP_ST_REQ_DATA_COMPLETE:
     if ((ret = fetch_response_header()) < 0) {
       printf("get response header failed\n");
-      goto done;
+      return ret;
     }
   case HTTP_ST_RES_HEADER_COMPLETE:
     if (response.status_code < 200 || response.status_code >= 300) {
       printf("Error: http status code %d\n", response.status_code);
-      goto done;
-    }
-    while (response.processed_data < response.content_length) {
-      if (fetch_response_data() <= 0) {
-        printf("no data or server requests close");
-        break;
+      if (response.status_code >= 500 || response.status_code == 429) {
+        _stats.server_errors++;
       }
+      return ret;
     }
+    ret = fetch_response_body();
     break;
   default:
     break;
   }
+  return ret;
+}
+
+int httpClient::send_attempt(llhttp_method_t method, const string &path) {
+  int ret = 0;
+
+  _net_error = false;
+  ret = send_request(method, path);
+  if (ret < 0 && _reused && http_st < HTTP_ST_RES_HEADER_COMPLETE) {
+    // the node may drop an idle keep-alive connection at any time, retry once
+    // on a fresh connection as long as no response was received
+    socket_close();
+    _stats.reconnects++;
+    _net_error = false;
+    ret = send_request(method, path);
+  }
+  node_report(!_net_error && !server_error());
+
+  // keep the connection only if the response was consumed completely and the
+  // server agreed to reuse it
+  if (ret < 0 || !_keep_alive || http_st != HTTP_ST_RES_DATA_COMPLETE ||
+      !llhttp_should_keep_alive(&http_parser)) {
+    socket_close();
+  }
+  return ret;
+}
+
+int httpClient::socket_send(llhttp_method_t method, const string &path,
+                            const string &data) {
+  return socket_send(method, path, data.data(), data.length(), _content_type);
+}
+
+int httpClient::socket_send(llhttp_method_t method, const string &path,
+                            char const *data, size_t len,
+                            char const *content_type) {
+  int ret = 0;
+  uint32_t delay_ms = 0;
+
+  _body = data;
+  _body_len = len;
+  _body_type = content_type;
 
-done:
-  _tls->close();
-  delete _tls;
-  _tls = NULL;
+  _stats.requests++;
+  _deadline = clock_ms() + _timeouts.total_ms;
+  for (unsigned attempt = 0;; attempt++) {
+    ret = send_attempt(method, path);
+    if (!retry_delay(method, ret, attempt, &delay_ms)) {
+      break;
+    }
+    printf("retry in %u ms\n", (unsigned)delay_ms);
+    _stats.retries++;
+    ThisThread::sleep_for(chrono::milliseconds(delay_ms));
+  }
   return ret;
 }
 
+int httpClient::pipeline_window(const vector<string> &paths, size_t first,
+                               size_t count) {
+  int ret = 0;
+  _deadline = clock_ms() + _timeouts.total_ms;
+  _net_error = false;
+  if ((ret = socket_prepare()) != 0) {
+    node_report(!_net_error);
+    printf("socket connect error!\n");
+    return ret;
+  }
+
+  // pack as many request heads as fit into one write
+  _pipeline_next = first;
+  _pipeline_end = first;
+  size_t pos = 0;
+  size_t sent_end = first; // end of the requests of the last complete write
+  bool send_failed = false;
+  for (size_t i = first; i < first + count; i++) {
+    http_head_t head = {HTTP_GET,         _nodes.node(_node).host.c_str(),
+                        paths[i].c_str(), _content_type,
+                        0,                true};
+    int head_len = http_write_head(&head, io_buf + pos, HTTP_BUF_SIZE - pos);
+    if (head_len < 0 && pos > 0) {
+      if ((ret = send_all(io_buf, pos)) < 0) {
+        send_failed = true;
+        break;
+      }
+      sent_end = _pipeline_end;
+      pos = 0;
+      head_len = http_write_head(&head, io_buf, HTTP_BUF_SIZE);
+    }
+    if (head_len < 0) {
+      printf("request header too long\n");
+      break;
+    }
+    pos += head_len;
+    if (i > first) {
+      _stats.pipelined++;
+    }
+    _pipeline_end++;
+  }
+  if (!send_failed && pos > 0 && send_all(io_buf, pos) >= 0) {
+    sent_end = _pipeline_end;
+  }
+  // only the responses of complete writes are waited for, nothing of a failed
+  // write is known to be delivered
+  _pipeline_end = sent_end;
+  http_st = HTTP_ST_REQ_DATA_COMPLETE;
+  _sent_at = clock_ms();
+
+  // responses come back in request order
+  while (_pipeline_next < _pipeline_end) {
+    nsapi_size_or_error_t bytes_or_err =
+        recv_timed(_timeouts.first_byte_ms, _stats.first_byte_timeouts);
+    if (bytes_or_err <= 0) {
+      if (bytes_or_err == 0) {
+        // a close-delimited body ends here
+        llhttp_finish(&http_parser);
+      }
+      printf("pipeline closed after %u responses\n",
+             (unsigned)(_pipeline_next - first));
+      break;
+    }
+    if (llhttp_execute(&http_parser, io_buf, bytes_or_err) != HPE_OK) {
+      printf("Error: http parser: %s\n", llhttp_get_error_reason(&http_parser));
+      break;
+    }
+  }
+
+  node_report(_pipeline_next > first);
+  if (_pipeline_next < first + count ||
+      !llhttp_should_keep_alive(&http_parser)) {
+    socket_close();
+  }
+  return _pipeline_next - first;
+}
+
+int httpClient::pipeline(const vector<string> &paths,
+                         vector<http_result_t> &results) {
+  bool keep_alive = _keep_alive;
+  bool retried = false;
+  size_t next = 0;
+
+  results.assign(paths.size(), http_result_t{-1, 0, ""});
+  _pipeline_results = &results;
+  // pipelined requests have to keep the connection open
+  _keep_alive = true;
+  _stats.requests += paths.size();
+
+  while (next < paths.size()) {
+    size_t count = min((size_t)HTTP_PIPELINE_DEPTH, paths.size() - next);
+    int answered = pipeline_window(paths, next, count);
+    if (answered <= 0) {
+      // give up if a fresh connection does not answer either
+      if (retried) {
+        break;
+      }
+      retried = true;
+      _stats.reconnects++;
+      continue;
+    }
+    retried = false;
+    next += answered;
+  }
+
+  _pipeline_results = NULL;
+  _keep_alive = keep_alive;
+  if (!_keep_alive) {
+    socket_close();
+  }
+  return next == paths.size() ? 0 : -1;
+}
+
+int httpClient::async_request(llhttp_method_t method, const string &path,
+                              char const *data, size_t len,
+                              char const *content_type, http_done_cb_t done,
+                              http_body_sink_t sink, void *ctx) {
+  if (!_queue || _async_busy) {
+    return -1;
+  }
+  _async_busy = true;
+  _stats.requests++;
+  _deadline = clock_ms() + _timeouts.total_ms;
+  _async_attempt = 0;
+  _async_method = method;
+  _async_path = path;
+  _body = data;
+  _body_len = len;
+  _body_type = content_type;
+  _async_done = done;
+  _async_retried = false;
+  _sink = sink;
+  _sink_ctx = ctx;
+  if (_queue->call(callback(this, &httpClient::async_start)) == 0) {
+    printf("event queue full\n");
+    _async_busy = false;
+    _sink = NULL;
+    _sink_ctx = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+void httpClient::async_start() {
+  int ret = 0;
+  size_t body_sent = 0;
+
+  _net_error = false;
+  http_st = HTTP_ST_UNINIT;
+
+  // connecting and sending block the event thread only briefly, waiting for
+  // the response does not
+  if ((ret = socket_prepare()) != 0) {
+    printf("socket connect error!\n");
+    async_finish(ret);
+    return;
+  }
+  if ((ret = send_header(_async_method, _async_path)) < 0) {
+    printf("send header failed\n");
+    async_finish(ret);
+    return;
+  }
+  body_sent = ret;
+  if ((ret = send_data(body_sent)) < 0) {
+    printf("send data failed\n");
+    async_finish(ret);
+    return;
+  }
+
+  _tls->set_blocking(false);
+  _tls->sigio(callback(this, &httpClient::async_sigio));
+  _async_first_byte = false;
+  async_arm(_timeouts.first_byte_ms);
+  // the response may be there already
+  async_read();
+}
+
+void httpClient::async_sigio() {
+  // called from the network stack, defer the work to the event queue
+  if (!_async_read_queued) {
+    _async_read_queued = true;
+    if (_queue->call(callback(this, &httpClient::async_read)) == 0) {
+      // the next socket event tries again, the timeout ends the request
+      _async_read_queued = false;
+    }
+  }
+}
+
+void httpClient::async_read() {
+  _async_read_queued = false;
+  if (!_async_busy || http_st < HTTP_ST_REQ_DATA_COMPLETE) {
+    return;
+  }
+
+  while (http_st < HTTP_ST_RES_DATA_COMPLETE) {
+    nsapi_size_or_error_t bytes_or_err = _tls->recv(io_buf, HTTP_BUF_SIZE);
+    if (bytes_or_err == NSAPI_ERROR_WOULD_BLOCK) {
+      // wait for the next socket event
+      return;
+    }
+    if (bytes_or_err == 0) {
+      if (fetch_response_eof() != 0) {
+        count_failure(_stats.recv_failures, bytes_or_err);
+        async_finish(-1);
+      } else {
+        async_finish(response.processed_data);
+      }
+      return;
+    }
+    if (bytes_or_err < 0) {
+      printf("Error: socket recv: %d\n", bytes_or_err);
+      count_failure(_stats.recv_failures, bytes_or_err);
+      async_finish(bytes_or_err);
+      return;
+    }
+    _stats.rx_bytes += bytes_or_err;
+    if (!_async_first_byte) {
+      // the node answered, the rest is bounded by the request deadline
+      _async_first_byte = true;
+      async_arm(_timeouts.total_ms);
+    }
+    if (llhttp_execute(&http_parser, io_buf, bytes_or_err) != HPE_OK) {
+      printf("Error: http parser: %s\n", llhttp_get_error_reason(&http_parser));
+      async_finish(-1);
+      return;
+    }
+  }
+  if (response.status_code >= 500 || response.status_code == 429) {
+    _stats.server_errors++;
+  }
+  async_finish(response.processed_data);
+}
+
+void httpClient::async_arm(uint32_t phase_ms) {
+  if (_async_timer) {
+    _queue->cancel(_async_timer);
+  }
+  _async_timer =
+      _queue->call_in(chrono::milliseconds(phase_timeout(phase_ms)),
+                      callback(this, &httpClient::async_timeout));
+}
+
+void httpClient::async_timeout() {
+  _async_timer = 0;
+  if (!_async_busy) {
+    return;
+  }
+  printf("Error: response timeout\n");
+  count_failure(_async_first_byte ? _stats.total_timeouts
+                                  : _stats.first_byte_timeouts,
+                NSAPI_ERROR_TIMEOUT);
+  async_finish(NSAPI_ERROR_TIMEOUT);
+}
+
+void httpClient::async_finish(int ret) {
+  uint32_t delay_ms = 0;
+
+  if (_async_timer) {
+    _queue->cancel(_async_timer);
+    _async_timer = 0;
+  }
+  if (_tls) {
+    _tls->sigio(nullptr);
+    _tls->set_blocking(true);
+  }
+
+  if (ret < 0 && _reused && !_async_retried &&
+      http_st < HTTP_ST_RES_HEADER_COMPLETE) {
+    // same as send_attempt(), an idle connection may have been dropped
+    socket_close();
+    _stats.reconnects++;
+    _async_retried = true;
+    http_st = HTTP_ST_UNINIT;
+    if (_queue->call(callback(this, &httpClient::async_start)) != 0) {
+      return;
+    }
+    // no event to resend it, the request ends with the error
+    printf("event queue full\n");
+  }
+  node_report(!_net_error && !server_error());
+
+  if (ret < 0 || !_keep_alive || http_st != HTTP_ST_RES_DATA_COMPLETE ||
+      !llhttp_should_keep_alive(&http_parser)) {
+    socket_close();
+  }
+
+  if (retry_delay(_async_method, ret, _async_attempt, &delay_ms)) {
+    printf("retry in %u ms\n", (unsigned)delay_ms);
+    _stats.retries++;
+    _async_attempt++;
+    _async_retried = false;
+    // reads still pending on the queue must not take this response
+    http_st = HTTP_ST_UNINIT;
+    if (_queue->call_in(chrono::milliseconds(delay_ms),
+                        callback(this, &httpClient::async_start)) != 0) {
+      return;
+    }
+    printf("event queue full\n");
+  }
+  _sink = NULL;
+  _sink_ctx = NULL;
+  // the callback may start the next request
+  http_done_cb_t done = _async_done;
+  _async_busy = false;
+  if (done) {
+    done(this, ret);
+  }
+}
+
+int httpClient::get_async(const string &path, http_done_cb_t done,
+                          http_body_sink_t sink, void *ctx) {
+  return async_request(HTTP_GET, path, NULL, 0, _content_type, done, sink,
+                       ctx);
+}
+
+int httpClient::post_async(const string &path, const string &data,
+                           http_done_cb_t done, http_body_sink_t sink,
+                           void *ctx) {
+  if (_async_busy) {
+    return -1;
+  }
+  // the caller's string may be gone before the request is sent
+  _async_data = data;
+  return async_request(HTTP_POST, path, _async_data.data(),
+                       _async_data.length(), _content_type, done, sink, ctx);
+}
+
+int httpClient::post_async(const string &path, char const *data, size_t len,
+                           char const *content_type, http_done_cb_t done) {
+  return async_request(HTTP_POST, path, data, len, content_type, done, NULL,
+                       NULL);
+}
+
+void httpClient::set_event_queue(EventQueue *queue) { _queue = queue; }
+
 int httpClient::get(const string &path) {
   return socket_send(HTTP_GET, path, "");
 }
@@ -247,5 +850,79 @@ int httpClient::post(const string &path, const string &data) {
   return socket_send(HTTP_POST, path, data);
 }
 
-string httpClient::response_data() { return response.buffer; }
+int httpClient::post(const string &path, char const *data, size_t len,
+                     char const *content_type) {
+  return socket_send(HTTP_POST, path, data, len, content_type);
+}
+
+int httpClient::parse_response(char const *data, size_t len,
+                               size_t read_len, int end) {
+  int ret = 0;
+  if (_async_busy || read_len == 0) {
+    return -1;
+  }
+  _canned = data;
+  _canned_len = len;
+  _canned_read = read_len;
+  _canned_end = end;
+
+  llhttp_reset(&http_parser);
+  response.buffer.clear();
+  response.content_length = 0;
+  response.status_code = 0;
+  response.processed_data = 0;
+  http_st = HTTP_ST_REQ_DATA_COMPLETE;
+  _deadline = clock_ms() + _timeouts.total_ms;
+
+  if ((ret = fetch_response_header()) >= 0) {
+    ret = fetch_response_body();
+  }
+  _canned = NULL;
+  _canned_len = 0;
+  return ret;
+}
+
+int httpClient::get(const string &path, http_body_sink_t sink, void *ctx) {
+  _sink = sink;
+  _sink_ctx = ctx;
+  int ret = socket_send(HTTP_GET, path, "");
+  _sink = NULL;
+  _sink_ctx = NULL;
+  return ret;
+}
+
+int httpClient::post(const string &path, const string &data,
+                     http_body_sink_t sink, void *ctx) {
+  _sink = sink;
+  _sink_ctx = ctx;
+  int ret = socket_send(HTTP_POST, path, data);
+  _sink = NULL;
+  _sink_ctx = NULL;
+  return ret;
+}
+
+void httpClient::set_timeouts(const http_timeouts_t &timeouts) {
+  _timeouts = timeouts;
+}
+
+void httpClient::set_retry(const http_retry_t &retry) { _retry = retry; }
+
+int httpClient::add_node(const char *host, uint16_t port) {
+  return _nodes.add(host, port);
+}
+
+void httpClient::set_keep_alive(bool enable) {
+  _keep_alive = enable;
+  if (!enable) {
+    socket_close();
+  }
+}
+
+void httpClient::set_content_type(char const *content_type) {
+  _content_type = content_type;
+}
+
+void httpClient::disconnect() { socket_close(); }
+
+const string &httpClient::response_data() { return response.buffer; }
 int httpClient::response_status_code() { return response.status_code; }
\ No newline at end of file
@@ -10,10 +10,16 @@
 #ifndef __HTTP_CLIENT_H__
 #define __HTTP_CLIENT_H__
 
+#include "dnsCache.h"
+#include "httpRetry.h"
 #include "llhttp.h"
 #include "main_config.h"
 #include "mbed.h"
+#include "nodePool.h"
+#include "tlsTransport.h"
+#include <algorithm>
 #include <string>
+#include <vector>
 
 typedef struct {
   string buffer;            // data buffer
@@ -22,6 +28,69 @@ typedef struct {
   unsigned int status_code; // http status code
 } http_data_t;
 
+/**
+ * @brief Consumer of response body chunks
+ *
+ * Chunks point into the I/O buffer and are only valid during the call.
+ *
+ * @return int 0 to continue, non-zero to abort the response
+ */
+typedef int (*http_body_sink_t)(void *ctx, char const *at, size_t length);
+
+class httpClient;
+
+/**
+ * @brief Completion of an asynchronous request
+ *
+ * Called on the event queue thread with the same result a blocking request
+ * returns.
+ */
+typedef mbed::Callback<void(httpClient *client, int ret)> http_done_cb_t;
+
+typedef struct {
+  llhttp_method_t method;
+  string path;
+  string data;
+} http_request_t;
+
+typedef struct {
+  int ret;                  // socket_send() result, negative on error
+  unsigned int status_code; // http status code
+  string body;              // response data
+} http_result_t;
+
+typedef struct {
+  uint32_t requests;   // requests sent
+  uint32_t reused;     // requests sent over an already open connection
+  uint32_t handshakes; // TLS handshakes performed, full and abbreviated
+  uint32_t resumed;    // abbreviated handshakes from a cached session
+  uint32_t reconnects; // reused connections dropped by the server and reopened
+  uint32_t pipelined;  // requests sent before the previous response arrived
+  uint32_t chunks;     // chunks of chunked transfer-encoded responses
+  uint32_t writes;     // TLS writes, one record each up to the record size
+  uint32_t tx_bytes;   // HTTP bytes sent, without TLS overhead
+  uint32_t rx_bytes;   // HTTP bytes received, without TLS overhead
+  uint32_t retries;    // requests sent again after a backoff
+  uint32_t failovers;  // retries sent to another node without a backoff
+
+  // failures by class, a timeout counts in the phase it happened in
+  uint32_t dns_failures;
+  uint32_t connect_failures;
+  uint32_t handshake_failures;
+  uint32_t send_failures;
+  uint32_t recv_failures;       // errors or connection closed by the server
+  uint32_t first_byte_timeouts; // no response after sending a request
+  uint32_t total_timeouts;      // request time limit passed in any phase
+  uint32_t server_errors;       // 5xx and 429 responses
+} http_stats_t;
+
+typedef struct {
+  uint32_t connect_ms;    // TCP connect
+  uint32_t handshake_ms;  // TLS handshake
+  uint32_t first_byte_ms; // from the request to the first response byte
+  uint32_t total_ms;      // the whole request including retries
+} http_timeouts_t;
+
 typedef enum {
   HTTP_ST_UNINIT = 0,
   HTTP_ST_INIT,
@@ -36,44 +105,246 @@ typedef enum {
 
 class httpClient {
 public:
-  httpClient() : _wifi(WiFiInterface::get_default_instance()) {
+  httpClient()
+      : _wifi(WiFiInterface::get_default_instance()),
+        _dns(resolve_host, this, clock_ms, DNS_CACHE_TTL, DNS_NEGATIVE_TTL),
+        _nodes(clock_ms, NODE_COOLDOWN, NODE_PROBE_INTERVAL),
+        _keep_alive(HTTP_KEEP_ALIVE) {
+    // the configured node comes first, the others are for failover
+    _nodes.add(IOTA_NODE_HOST, IOTA_NODE_PORT);
+    _nodes.add_list(IOTA_NODE_LIST, IOTA_NODE_PORT);
+    _node = 0;
+    _conn_node = -1;
+    _reused = false;
+    _sent_at = 0;
+    _latency_ms = -1;
     // http parser init
+    llhttp_settings_init(&parser_setting);
     parser_setting.on_message_begin = on_message_begin;
     parser_setting.on_headers_complete = on_headers_complete;
     parser_setting.on_body = on_body;
+    parser_setting.on_chunk_header = on_chunk_header;
+    parser_setting.on_message_complete = on_message_complete;
     llhttp_init(&http_parser, HTTP_RESPONSE, &parser_setting);
+    http_parser.data = this;
+    http_st = HTTP_ST_UNINIT;
+    response.content_length = 0;
+    response.processed_data = 0;
+    response.status_code = 0;
+    _sink = NULL;
+    _sink_ctx = NULL;
     _tls = NULL;
+    _content_type = "application/json";
+    _body = NULL;
+    _body_len = 0;
+    _body_type = _content_type;
+    _pipeline_results = NULL;
+    _pipeline_next = 0;
+    _pipeline_end = 0;
+    _canned = NULL;
+    _canned_len = 0;
+    _canned_read = 0;
+    _canned_end = 0;
+    _timeouts = {HTTP_CONNECT_TIMEOUT, HTTP_HANDSHAKE_TIMEOUT,
+                 HTTP_FIRST_BYTE_TIMEOUT, HTTP_TOTAL_TIMEOUT};
+    _retry = {HTTP_RETRIES, HTTP_BACKOFF_BASE, HTTP_BACKOFF_MAX};
+    _deadline = 0;
+    _deadline_bound = false;
+    _net_error = false;
+    _queue = NULL;
+    _async_busy = false;
+    _async_read_queued = false;
+    _async_timer = 0;
+    memset(&_stats, 0, sizeof(_stats));
   };
+  ~httpClient() {
+    socket_close();
+    delete _tls;
+  }
   int post(const string &path, const string &data);
   int get(const string &path);
+  // a body of any content type, sent from the caller's buffer
+  int post(const string &path, char const *data, size_t len,
+           char const *content_type);
+  // stream the response body into a sink instead of response_data()
+  int post(const string &path, const string &data, http_body_sink_t sink,
+           void *ctx);
+  int get(const string &path, http_body_sink_t sink, void *ctx);
   int response_status_code();
   int socket_send(llhttp_method_t method, const string &path,
                   const string &data);
-  string response_data(); // get response data
+  int socket_send(llhttp_method_t method, const string &path,
+                  char const *data, size_t len, char const *content_type);
+  const string &response_data(); // get response data
+
+  /**
+   * @brief Send GET requests back to back on one connection
+   *
+   * Up to HTTP_PIPELINE_DEPTH requests are in flight, the responses are
+   * matched to the requests in order. Requests left unanswered by a closed
+   * connection are sent again on a new one.
+   *
+   * @param[in] paths The request paths
+   * @param[out] results The result of each request
+   * @return int 0 if every request got a response, -1 otherwise
+   */
+  int pipeline(const vector<string> &paths, vector<http_result_t> &results);
+
+  /**
+   * @brief Send a request without blocking the caller
+   *
+   * The connection is set up and the request is sent on the event queue
+   * thread, then the response is read from socket events as it arrives. One
+   * request per client can be in progress.
+   *
+   * @param[in] path The request path
+   * @param[in] done Called with the result when the response is complete
+   * @param[in] sink Optional body sink, called on the event queue thread
+   * @param[in] ctx The sink context
+   * @return int 0 if the request was queued, -1 if the client is busy or has
+   * no event queue
+   */
+  int get_async(const string &path, http_done_cb_t done,
+                http_body_sink_t sink = NULL, void *ctx = NULL);
+  int post_async(const string &path, const string &data, http_done_cb_t done,
+                 http_body_sink_t sink = NULL, void *ctx = NULL);
+  // the data is not copied and has to stay valid until done is called
+  int post_async(const string &path, char const *data, size_t len,
+                 char const *content_type, http_done_cb_t done);
+  void set_event_queue(EventQueue *queue); // runs asynchronous requests
+  bool busy() { return _async_busy; }
+
+  /**
+   * @brief Set the time limits of requests
+   *
+   * Network errors, timeouts and 5xx or 429 responses are retried with
+   * exponential backoff. A POST is only sent again if it did not reach the
+   * node completely or the node asked for it with 429 or 503.
+   */
+  void set_timeouts(const http_timeouts_t &timeouts);
+  void set_retry(const http_retry_t &retry);
+  int add_node(const char *host, uint16_t port); // to fail over to
+  const nodePool &nodes() { return _nodes; }
+  void set_keep_alive(bool enable);
+  void set_content_type(char const *content_type); // of request bodies
+  void disconnect(); // close the persistent connection if any
+  const http_stats_t &stats() { return _stats; }
+
+  /**
+   * @brief Read a canned response as if it came from the node
+   *
+   * Checks the response parsing without a connection: the data is handed
+   * over in reads of at most read_len bytes, then the TLS read returns end
+   * as a blocking tlsTransport would report it.
+   *
+   * @param[in] data The response with status line and headers
+   * @param[in] len The length of data
+   * @param[in] read_len The largest read
+   * @param[in] end The mbedtls_ssl_read() result after the data, e.g.
+   * MBEDTLS_ERR_SSL_CONN_EOF for a server closing without close_notify
+   * @return int the body length, -1 if the response is malformed or truncated
+   */
+  int parse_response(char const *data, size_t len, size_t read_len,
+                     int end = 0);
+  const dns_stats_t &dns_stats() { return _dns.stats(); }
 
 private:
   static int on_message_begin(llhttp_t *parser);
   static int on_headers_complete(llhttp_t *parser);
   static int on_body(llhttp_t *parser, char const *at, size_t length);
+  static int on_chunk_header(llhttp_t *parser);
+  static int on_message_complete(llhttp_t *parser);
+  static int resolve_host(void *ctx, const char *host, char *addr,
+                          size_t addr_len);
+  static uint64_t clock_ms();
+  tlsTransport *transport(); // allocated on first use
+  int phase_timeout(uint32_t phase_ms); // limited by the request deadline
+  void count_failure(uint32_t &counter, int err);
+  bool server_error(); // the node answered with 5xx or 429
+  bool retryable(llhttp_method_t method, int ret);
+  bool retry_delay(llhttp_method_t method, int ret, unsigned attempt,
+                   uint32_t *delay_ms);
+  nsapi_size_or_error_t recv_timed(uint32_t phase_ms,
+                                   uint32_t &timeout_counter);
+  void node_report(bool ok);
+  int socket_connect();
   int socket_prepare(); // init buffer and http status
   int socket_close();
 
-  int send_header(llhttp_method_t method, const string &path, size_t data_len);
-  int send_data(const string &data);
+  int send_all(char const *buf, size_t len);
+  // returns the number of body bytes sent along with the header
+  int send_header(llhttp_method_t method, const string &path);
+  int send_data(size_t offset); // of the request body
   int fetch_response_header();
   int fetch_response_data();
+  int fetch_response_eof();
+  int fetch_response_body(); // after the header, until the message completes
   int recv(string &response);
+  int send_request(llhttp_method_t method, const string &path);
+  int send_attempt(llhttp_method_t method, const string &path);
+  int pipeline_window(const vector<string> &paths, size_t first,
+                      size_t count);
+  int async_request(llhttp_method_t method, const string &path,
+                    char const *data, size_t len, char const *content_type,
+                    http_done_cb_t done, http_body_sink_t sink, void *ctx);
+  void async_start();
+  void async_sigio();
+  void async_read();
+  void async_arm(uint32_t phase_ms);
+  void async_timeout();
+  void async_finish(int ret);
 
   http_data_t request;
-  static http_data_t response;
-  static http_state_t http_st;
+  http_data_t response;
+  http_state_t http_st;
   llhttp_t http_parser;
   llhttp_settings_t parser_setting;
 
-  char recv_buf[HTTP_BUF_SIZE];
+  // request header on send, response data on receive
+  char io_buf[HTTP_BUF_SIZE];
 
   WiFiInterface *_wifi;
-  TLSSocket *_tls;
+  dnsCache _dns;
+  nodePool _nodes;
+  int _node;           // node of the current request
+  int _conn_node;      // node of the open connection
+  bool _reused;        // the request went over an open connection
+  uint64_t _sent_at;   // the request was sent completely
+  int32_t _latency_ms; // to the first response byte, -1 if none yet
+  tlsTransport *_tls;
+  bool _keep_alive;
+  char const *_content_type;
+  char const *_body; // of the current request
+  size_t _body_len;
+  char const *_body_type;
+  http_stats_t _stats;
+  http_body_sink_t _sink;
+  void *_sink_ctx;
+  vector<http_result_t> *_pipeline_results; // responses of a pipeline
+  size_t _pipeline_next;                    // request of the next response
+  size_t _pipeline_end;
+  char const *_canned; // served instead of the socket by parse_response
+  size_t _canned_len;
+  size_t _canned_read;
+  int _canned_end;
+
+  http_timeouts_t _timeouts;
+  http_retry_t _retry;
+  uint64_t _deadline;   // of the current request
+  bool _deadline_bound; // the last wait was cut short by the deadline
+  bool _net_error;      // the last attempt failed in the network
+
+  EventQueue *_queue;
+  http_done_cb_t _async_done;
+  llhttp_method_t _async_method;
+  string _async_path;
+  string _async_data; // copy of a string body
+  bool _async_busy;
+  bool _async_retried;              // resent once on a new connection
+  bool _async_first_byte;           // some of the response arrived
+  unsigned _async_attempt;          // retries after a backoff
+  int _async_timer;                 // timeout event on the queue
+  volatile bool _async_read_queued; // a read event is pending on the queue
 };
 
 #endif
\ No newline at end of file
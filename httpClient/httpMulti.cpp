@@ -0,0 +1,91 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Concurrent requests over several httpClient connections
+ *
+ */
+
+#include "httpMulti.h"
+
+httpMulti::httpMulti(size_t connections)
+    : _requests(NULL), _results(NULL), _next(0) {
+  for (size_t i = 0; i < connections; i++) {
+    httpClient *client = new httpClient();
+    if (!client) {
+      printf("[%s:%d] new client failed\n", __func__, __LINE__);
+      break;
+    }
+    _clients.push_back(client);
+  }
+}
+
+httpMulti::~httpMulti() {
+  for (auto client : _clients) {
+    delete client;
+  }
+}
+
+void httpMulti::worker_main(worker_t *worker) {
+  httpMulti *multi = worker->multi;
+  while (true) {
+    multi->_mutex.lock();
+    size_t i = multi->_next++;
+    multi->_mutex.unlock();
+    if (i >= multi->_requests->size()) {
+      break;
+    }
+
+    const http_request_t &req = (*multi->_requests)[i];
+    http_result_t &res = (*multi->_results)[i];
+    res.ret = worker->client->socket_send(req.method, req.path, req.data);
+    res.status_code = worker->client->response_status_code();
+    res.body = worker->client->response_data();
+  }
+}
+
+int httpMulti::run(const vector<http_request_t> &requests,
+                   vector<http_result_t> &results) {
+  size_t workers = min(_clients.size(), requests.size());
+  vector<worker_t> ctx(workers);
+  vector<Thread *> threads;
+
+  results.assign(requests.size(), http_result_t{-1, 0, ""});
+  _requests = &requests;
+  _results = &results;
+  _next = 0;
+
+  // the calling thread is a worker too
+  for (size_t i = 1; i < workers; i++) {
+    ctx[i].multi = this;
+    ctx[i].client = _clients[i];
+    Thread *t = new Thread(osPriorityNormal, HTTP_THREAD_STACK_SIZE, NULL,
+                           "http");
+    if (!t || t->start(callback(worker_main, &ctx[i])) != osOK) {
+      printf("[%s:%d] start worker failed\n", __func__, __LINE__);
+      delete t;
+      break;
+    }
+    threads.push_back(t);
+  }
+  if (workers > 0) {
+    ctx[0].multi = this;
+    ctx[0].client = _clients[0];
+    worker_main(&ctx[0]);
+  }
+
+  for (auto t : threads) {
+    t->join();
+    delete t;
+  }
+  _requests = NULL;
+  _results = NULL;
+
+  for (auto &res : results) {
+    if (res.ret < 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Concurrent requests over several httpClient connections
+ *
+ */
+
+#ifndef __HTTP_MULTI_H__
+#define __HTTP_MULTI_H__
+
+#include "httpClient.h"
+#include "main_config.h"
+#include "mbed.h"
+#include <string>
+#include <vector>
+
+class httpMulti {
+public:
+  httpMulti(size_t connections = HTTP_CONNECTIONS);
+  ~httpMulti();
+
+  /**
+   * @brief Send requests concurrently, one worker thread per connection
+   *
+   * Each connection takes the next pending request until all are done, so the
+   * results are in the order of the requests.
+   *
+   * @param[in] requests The requests
+   * @param[out] results The result of each request
+   * @return int 0 if every request got a response, -1 otherwise
+   */
+  int run(const vector<http_request_t> &requests,
+          vector<http_result_t> &results);
+  size_t connections() { return _clients.size(); }
+  httpClient &client(size_t i) { return *_clients[i]; }
+
+private:
+  typedef struct {
+    httpMulti *multi;
+    httpClient *client;
+  } worker_t;
+
+  static void worker_main(worker_t *worker);
+
+  vector<httpClient *> _clients;
+  const vector<http_request_t> *_requests;
+  vector<http_result_t> *_results;
+  size_t _next;
+  Mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,22 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Retry policy with exponential backoff and jitter
+ *
+ */
+
+#include "httpRetry.h"
+
+uint32_t http_backoff_ms(http_retry_t const *policy, unsigned attempt,
+                         uint32_t rnd) {
+  uint32_t backoff = policy->max_ms;
+  // doubling stops at the cap, shifting further would overflow
+  if (attempt < 32 && policy->base_ms <= (policy->max_ms >> attempt)) {
+    backoff = policy->base_ms << attempt;
+  }
+  // equal jitter, at least half of the backoff is always waited
+  uint32_t half = backoff / 2;
+  return half + rnd % (backoff - half + 1);
+}
@@ -0,0 +1,46 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Retry policy with exponential backoff and jitter
+ *
+ * The backoff doubles with every attempt up to a cap, and a random part of it
+ * keeps clients which failed together from retrying together. It has no Mbed
+ * OS dependency and builds on a host as well.
+ */
+
+#ifndef __HTTP_RETRY_H__
+#define __HTTP_RETRY_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint8_t retries;  // attempts after the first one
+  uint32_t base_ms; // backoff before the first retry
+  uint32_t max_ms;  // upper limit of the backoff
+} http_retry_t;
+
+/**
+ * @brief Get the time to wait before a retry
+ *
+ * The result is in [backoff / 2, backoff] with backoff = base_ms * 2^attempt
+ * limited to max_ms.
+ *
+ * @param[in] policy The retry policy
+ * @param[in] attempt The number of retries done so far
+ * @param[in] rnd A random number, a device unique source avoids lockstep
+ * @return uint32_t The delay in milliseconds
+ */
+uint32_t http_backoff_ms(http_retry_t const *policy, unsigned attempt,
+                         uint32_t rnd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
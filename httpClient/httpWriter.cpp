@@ -0,0 +1,69 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief HTTP request head writer
+ *
+ */
+
+#include <string.h>
+
+#include "httpWriter.h"
+
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t pos;
+  bool overflow;
+} writer_t;
+
+static void put_str(writer_t *w, char const *str) {
+  size_t n = strlen(str);
+  if (w->overflow || w->pos + n > w->len) {
+    w->overflow = true;
+    return;
+  }
+  memcpy(w->buf + w->pos, str, n);
+  w->pos += n;
+}
+
+static void put_uint(writer_t *w, size_t v) {
+  char digits[24];
+  size_t n = 0;
+  do {
+    digits[n++] = '0' + (v % 10);
+    v /= 10;
+  } while (v);
+  if (w->overflow || w->pos + n > w->len) {
+    w->overflow = true;
+    return;
+  }
+  while (n) {
+    w->buf[w->pos++] = digits[--n];
+  }
+}
+
+int http_write_head(http_head_t const *head, char *buf, size_t buf_len) {
+  writer_t w = {buf, buf_len, 0, false};
+  if (head->method != HTTP_GET && head->method != HTTP_POST) {
+    // not support yet
+    return -1;
+  }
+
+  put_str(&w, llhttp_method_name(head->method));
+  put_str(&w, " ");
+  put_str(&w, head->path);
+  put_str(&w, " HTTP/1.1\r\nHost: ");
+  put_str(&w, head->host);
+  put_str(&w, "\r\nContent-Type: ");
+  put_str(&w, head->content_type);
+  put_str(&w, "\r\nUser-Agent: IOTA CClient\r\n"
+              "Accept: */*\r\n");
+  put_str(&w, head->keep_alive ? "Connection: keep-alive\r\n"
+                               : "Connection: close\r\n");
+  put_str(&w, "Content-Length: ");
+  put_uint(&w, head->content_length);
+  put_str(&w, "\r\n\r\n");
+  return w.overflow ? -1 : (int)w.pos;
+}
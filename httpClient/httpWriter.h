@@ -0,0 +1,48 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief HTTP request head writer
+ *
+ * Formats the request line and headers into a caller buffer without heap
+ * allocation. It has no Mbed OS dependency and builds on a host as well.
+ */
+
+#ifndef __HTTP_WRITER_H__
+#define __HTTP_WRITER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "llhttp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  llhttp_method_t method;
+  char const *host;
+  char const *path;
+  char const *content_type;
+  size_t content_length;
+  bool keep_alive;
+} http_head_t;
+
+/**
+ * @brief Write a request head into a buffer
+ *
+ * @param[in] head The request
+ * @param[out] buf The output buffer
+ * @param[in] buf_len The size of the buffer
+ * @return int The length of the head, -1 if the buffer is too small or the
+ * method is not supported
+ */
+int http_write_head(http_head_t const *head, char *buf, size_t buf_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,133 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Pool of IOTA nodes with latency-aware selection
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nodePool.h"
+
+nodePool::nodePool(node_clock_t clock, uint32_t cooldown_ms,
+                   uint32_t probe_ms)
+    : _clock(clock), _cooldown(cooldown_ms), _probe(probe_ms), _count(0) {}
+
+int nodePool::add(const char *host, uint16_t port) {
+  if (!host || host[0] == '\0' || _count >= NODE_POOL_SIZE) {
+    printf("[%s:%d] invalid node or pool full\n", __func__, __LINE__);
+    return -1;
+  }
+  node_info_t &n = _nodes[_count];
+  n.host = host;
+  n.port = port;
+  n.latency_ms = 0;
+  n.error_rate = 0;
+  n.failures = 0;
+  n.measured = false;
+  n.sampled_at = 0;
+  n.down_until = 0;
+  n.requests = 0;
+  n.errors = 0;
+  return _count++;
+}
+
+int nodePool::add_list(const char *list, uint16_t default_port) {
+  int added = 0;
+  if (!list) {
+    return 0;
+  }
+  while (*list) {
+    const char *end = strchr(list, ',');
+    size_t len = end ? (size_t)(end - list) : strlen(list);
+    std::string entry(list, len);
+    list += end ? len + 1 : len;
+
+    // trim spaces
+    size_t first = entry.find_first_not_of(' ');
+    if (first == std::string::npos) {
+      continue;
+    }
+    entry = entry.substr(first, entry.find_last_not_of(' ') - first + 1);
+
+    uint16_t port = default_port;
+    size_t colon = entry.rfind(':');
+    if (colon != std::string::npos) {
+      char *num_end = NULL;
+      unsigned long num = strtoul(entry.c_str() + colon + 1, &num_end, 10);
+      if (colon + 1 == entry.length() || *num_end != '\0' || num == 0 ||
+          num > 65535) {
+        printf("[%s:%d] invalid port in %s\n", __func__, __LINE__,
+               entry.c_str());
+        return -1;
+      }
+      port = num;
+      entry.erase(colon);
+    }
+    if (add(entry.c_str(), port) < 0) {
+      return -1;
+    }
+    added++;
+  }
+  return added;
+}
+
+int nodePool::select() {
+  uint64_t now = _clock();
+  int best = -1;
+  int fallback = -1;
+
+  for (size_t i = 0; i < _count; i++) {
+    const node_info_t &n = _nodes[i];
+    if (now < n.down_until) {
+      if (fallback < 0 || n.down_until < _nodes[fallback].down_until) {
+        fallback = i;
+      }
+      continue;
+    }
+    // unknown and outdated estimates are refreshed first
+    if (!n.measured || now - n.sampled_at >= _probe) {
+      return i;
+    }
+    if (best < 0 || n.latency_ms < _nodes[best].latency_ms) {
+      best = i;
+    }
+  }
+  return best >= 0 ? best : fallback;
+}
+
+void nodePool::report(int node, bool ok, int32_t latency_ms) {
+  if (node < 0 || (size_t)node >= _count) {
+    return;
+  }
+  node_info_t &n = _nodes[node];
+  uint64_t now = _clock();
+
+  n.requests++;
+  if (ok) {
+    n.failures = 0;
+    n.error_rate -= n.error_rate / 4;
+    if (latency_ms >= 0) {
+      // EWMA with a weight of 1/4 for the new sample
+      int32_t diff = latency_ms - (int32_t)n.latency_ms;
+      n.latency_ms = n.measured ? n.latency_ms + diff / 4 : latency_ms;
+      n.measured = true;
+      n.sampled_at = now;
+    }
+    return;
+  }
+
+  n.errors++;
+  n.failures++;
+  n.error_rate += (1000 - n.error_rate) / 4;
+  if (n.failures >= NODE_MAX_FAILURES ||
+      n.error_rate >= NODE_MAX_ERROR_RATE) {
+    // give the node a rest, the next request after the cooldown probes it
+    n.down_until = now + _cooldown;
+    n.failures = 0;
+  }
+}
@@ -0,0 +1,96 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief Pool of IOTA nodes with latency-aware selection
+ *
+ * Keeps an EWMA of the response latency and of the error rate of every node
+ * and selects the fastest healthy one. A node which fails repeatedly is left
+ * out for a cooldown period, and estimates older than the probe interval are
+ * refreshed by sending the next request to that node. Like dnsCache it only
+ * needs a clock callback and builds on a host as well.
+ */
+
+#ifndef __NODE_POOL_H__
+#define __NODE_POOL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#ifndef NODE_POOL_SIZE
+#define NODE_POOL_SIZE 4
+#endif
+
+#define NODE_MAX_FAILURES 2     // consecutive failures before a cooldown
+#define NODE_MAX_ERROR_RATE 500 // error rate in 1/1000 before a cooldown
+
+typedef uint64_t (*node_clock_t)(void); // monotonic time in milliseconds
+
+typedef struct {
+  std::string host;
+  uint16_t port;
+  uint32_t latency_ms;  // EWMA of the time to the first response byte
+  uint16_t error_rate;  // EWMA of failed requests in 1/1000
+  uint8_t failures;     // consecutive failures
+  bool measured;        // latency_ms holds a sample
+  uint64_t sampled_at;  // time of the last latency sample
+  uint64_t down_until;  // left out before, unless all nodes are down
+  uint32_t requests;    // requests reported
+  uint32_t errors;      // failed requests reported
+} node_info_t;
+
+class nodePool {
+public:
+  nodePool(node_clock_t clock, uint32_t cooldown_ms, uint32_t probe_ms);
+
+  /**
+   * @brief Add a node to the pool
+   *
+   * @return int The index of the node, -1 if the pool is full
+   */
+  int add(const char *host, uint16_t port);
+
+  /**
+   * @brief Add nodes from a list like "node1.example.com:443,node2.example.com"
+   *
+   * @param[in] list Comma separated hostnames with optional port numbers
+   * @param[in] default_port The port of nodes without a port number
+   * @return int The number of nodes added, -1 on a malformed entry or a full
+   * pool
+   */
+  int add_list(const char *list, uint16_t default_port);
+
+  /**
+   * @brief Get the node for the next request
+   *
+   * Nodes without a recent latency sample are picked first, otherwise the
+   * healthy node with the lowest latency. If every node is down, the one
+   * coming back first is picked.
+   *
+   * @return int The index of the node, -1 if the pool is empty
+   */
+  int select();
+
+  /**
+   * @brief Record the outcome of a request
+   *
+   * @param[in] node The index of the node
+   * @param[in] ok The node answered the request properly
+   * @param[in] latency_ms The time to the first response byte, negative if
+   * unknown
+   */
+  void report(int node, bool ok, int32_t latency_ms);
+  size_t size() const { return _count; }
+  const node_info_t &node(size_t i) const { return _nodes[i]; }
+
+private:
+  node_clock_t _clock;
+  uint32_t _cooldown;
+  uint32_t _probe;
+  node_info_t _nodes[NODE_POOL_SIZE];
+  size_t _count;
+};
+
+#endif
@@ -0,0 +1,208 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief TLS session cache for abbreviated handshakes
+ *
+ */
+
+#include "tlsSessionCache.h"
+#include "mbedtls/version.h"
+
+// session (de)serialization is available since Mbed TLS 2.19
+#if TLS_SESSION_PERSIST && (MBEDTLS_VERSION_NUMBER >= 0x02130000)
+#include "kvstore_global_api.h"
+#include "mbedtls/platform_util.h"
+#define SESSION_STORE_ENABLED 1
+#else
+#define SESSION_STORE_ENABLED 0
+#endif
+
+static std::string cache_key(const char *host, uint16_t port) {
+  return std::string(host) + ":" + std::to_string(port);
+}
+
+tlsSessionCache::tlsSessionCache() : _clock(0) {
+  for (size_t i = 0; i < TLS_SESSION_CACHE_SIZE; i++) {
+    mbedtls_ssl_session_init(&_entries[i].session);
+    _entries[i].last_used = 0;
+  }
+}
+
+tlsSessionCache::~tlsSessionCache() {
+  for (size_t i = 0; i < TLS_SESSION_CACHE_SIZE; i++) {
+    mbedtls_ssl_session_free(&_entries[i].session);
+  }
+}
+
+tlsSessionCache &tlsSessionCache::shared() {
+  static tlsSessionCache cache;
+  return cache;
+}
+
+tlsSessionCache::cache_entry_t *tlsSessionCache::find(const std::string &key) {
+  for (size_t i = 0; i < TLS_SESSION_CACHE_SIZE; i++) {
+    if (_entries[i].last_used != 0 && _entries[i].key == key) {
+      return &_entries[i];
+    }
+  }
+  return NULL;
+}
+
+tlsSessionCache::cache_entry_t *tlsSessionCache::evict(const std::string &key) {
+  // replace the least recently used entry
+  cache_entry_t *entry = &_entries[0];
+  for (size_t i = 1; i < TLS_SESSION_CACHE_SIZE; i++) {
+    if (_entries[i].last_used < entry->last_used) {
+      entry = &_entries[i];
+    }
+  }
+  mbedtls_ssl_session_free(&entry->session);
+  mbedtls_ssl_session_init(&entry->session);
+  entry->key = key;
+  entry->last_used = ++_clock;
+  return entry;
+}
+
+int tlsSessionCache::load(const char *host, uint16_t port,
+                          mbedtls_ssl_context *ssl) {
+  int ret = -1;
+  std::string key = cache_key(host, port);
+
+  _mutex.lock();
+  cache_entry_t *entry = find(key);
+  if (!entry) {
+    // not in memory, try the persistent store
+    entry = evict(key);
+    if (store_load(key, &entry->session) != 0) {
+      entry->key.clear();
+      entry->last_used = 0;
+      entry = NULL;
+    }
+  }
+  if (entry) {
+    entry->last_used = ++_clock;
+    // makes a deep copy into the SSL context
+    ret = mbedtls_ssl_set_session(ssl, &entry->session) == 0 ? 0 : -1;
+  }
+  _mutex.unlock();
+  return ret;
+}
+
+int tlsSessionCache::save(const char *host, uint16_t port,
+                          const mbedtls_ssl_context *ssl) {
+  int ret = 0;
+  std::string key = cache_key(host, port);
+
+  _mutex.lock();
+  cache_entry_t *entry = find(key);
+  if (entry) {
+    mbedtls_ssl_session_free(&entry->session);
+    mbedtls_ssl_session_init(&entry->session);
+    entry->last_used = ++_clock;
+  } else {
+    entry = evict(key);
+  }
+  if ((ret = mbedtls_ssl_get_session(ssl, &entry->session)) == 0) {
+    store_save(key, &entry->session);
+  } else {
+    entry->key.clear();
+    entry->last_used = 0;
+  }
+  _mutex.unlock();
+  return ret;
+}
+
+void tlsSessionCache::remove(const char *host, uint16_t port) {
+  std::string key = cache_key(host, port);
+
+  _mutex.lock();
+  cache_entry_t *entry = find(key);
+  if (entry) {
+    mbedtls_ssl_session_free(&entry->session);
+    mbedtls_ssl_session_init(&entry->session);
+    entry->key.clear();
+    entry->last_used = 0;
+  }
+  _mutex.unlock();
+
+  store_remove(key);
+}
+
+#if SESSION_STORE_ENABLED
+// KV store keys must not contain ':' or '/'
+static std::string store_key(const std::string &key) {
+  std::string kv_key = "/kv/tls.";
+  for (char c : key) {
+    kv_key.push_back((c == ':' || c == '/') ? '.' : c);
+  }
+  return kv_key;
+}
+
+int tlsSessionCache::store_load(const std::string &key,
+                                mbedtls_ssl_session *session) {
+  std::string kv_key = store_key(key);
+  kv_info_t info = {};
+  size_t actual_size = 0;
+  int ret = -1;
+
+  if (kv_get_info(kv_key.c_str(), &info) != MBED_SUCCESS || info.size == 0) {
+    return -1;
+  }
+  // the session holds the master secret, only take it from a secure store
+  if (!(info.flags & KV_REQUIRE_CONFIDENTIALITY_FLAG)) {
+    kv_remove(kv_key.c_str());
+    return -1;
+  }
+  unsigned char *buf = (unsigned char *)malloc(info.size);
+  if (!buf) {
+    return -1;
+  }
+  if (kv_get(kv_key.c_str(), buf, info.size, &actual_size) == MBED_SUCCESS &&
+      mbedtls_ssl_session_load(session, buf, actual_size) == 0) {
+    ret = 0;
+  }
+  mbedtls_platform_zeroize(buf, info.size);
+  free(buf);
+  return ret;
+}
+
+void tlsSessionCache::store_save(const std::string &key,
+                                 const mbedtls_ssl_session *session) {
+  size_t len = 0;
+  // get the serialized length first
+  mbedtls_ssl_session_save(session, NULL, 0, &len);
+  if (len == 0) {
+    return;
+  }
+  unsigned char *buf = (unsigned char *)malloc(len);
+  if (!buf) {
+    return;
+  }
+  // not persisted at all unless the store can keep the master secret
+  // confidential
+  if (mbedtls_ssl_session_save(session, buf, len, &len) == 0 &&
+      kv_set(store_key(key).c_str(), buf, len,
+             KV_REQUIRE_CONFIDENTIALITY_FLAG) != MBED_SUCCESS) {
+    printf("[%s:%d] KV store can not keep the TLS session confidential\n",
+           __func__, __LINE__);
+  }
+  mbedtls_platform_zeroize(buf, len);
+  free(buf);
+}
+
+void tlsSessionCache::store_remove(const std::string &key) {
+  kv_remove(store_key(key).c_str());
+}
+#else
+int tlsSessionCache::store_load(const std::string &key,
+                                mbedtls_ssl_session *session) {
+  return -1;
+}
+
+void tlsSessionCache::store_save(const std::string &key,
+                                 const mbedtls_ssl_session *session) {}
+
+void tlsSessionCache::store_remove(const std::string &key) {}
+#endif
@@ -0,0 +1,68 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief TLS session cache for abbreviated handshakes
+ *
+ * Sessions are kept by host:port and shared by all httpClient instances, so
+ * they outlive the connection they were negotiated on. With
+ * TLS_SESSION_PERSIST they are also written to the KV store and survive a
+ * reboot.
+ */
+
+#ifndef __TLS_SESSION_CACHE_H__
+#define __TLS_SESSION_CACHE_H__
+
+#include "main_config.h"
+#include "mbed.h"
+#include "mbedtls/ssl.h"
+#include <string>
+
+class tlsSessionCache {
+public:
+  tlsSessionCache();
+  ~tlsSessionCache();
+
+  /**
+   * @brief Set the cached session of a server on an SSL context
+   *
+   * @param[in] host The server hostname
+   * @param[in] port The server port
+   * @param[in] ssl An SSL context which has not started the handshake
+   * @return int 0 on hit, -1 on miss
+   */
+  int load(const char *host, uint16_t port, mbedtls_ssl_context *ssl);
+
+  /**
+   * @brief Keep the session negotiated on an SSL context
+   *
+   * @param[in] host The server hostname
+   * @param[in] port The server port
+   * @param[in] ssl An SSL context with a completed handshake
+   * @return int 0 on success
+   */
+  int save(const char *host, uint16_t port, const mbedtls_ssl_context *ssl);
+  void remove(const char *host, uint16_t port);
+
+  static tlsSessionCache &shared(); // the cache used by httpClient
+
+private:
+  typedef struct {
+    std::string key; // host:port
+    mbedtls_ssl_session session;
+    uint32_t last_used;
+  } cache_entry_t;
+
+  cache_entry_t *find(const std::string &key);
+  cache_entry_t *evict(const std::string &key);
+  int store_load(const std::string &key, mbedtls_ssl_session *session);
+  void store_save(const std::string &key, const mbedtls_ssl_session *session);
+  void store_remove(const std::string &key);
+
+  cache_entry_t _entries[TLS_SESSION_CACHE_SIZE];
+  uint32_t _clock;
+  Mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,245 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief TLS client transport on top of a TCP socket
+ *
+ */
+
+#include "tlsTransport.h"
+#include "root_ca_cert.h"
+
+static char const drbg_pers[] = "iota http client";
+
+tlsTransport::tlsTransport()
+    : _port(0), _timeout(-1), _initialized(false), _blocking(true),
+      _connected(false), _resumed(false) {
+  mbedtls_entropy_init(&_entropy);
+  mbedtls_ctr_drbg_init(&_drbg);
+  mbedtls_x509_crt_init(&_cacert);
+  mbedtls_ssl_config_init(&_conf);
+  mbedtls_ssl_init(&_ssl);
+}
+
+tlsTransport::~tlsTransport() {
+  close();
+  mbedtls_ssl_free(&_ssl);
+  mbedtls_ssl_config_free(&_conf);
+  mbedtls_x509_crt_free(&_cacert);
+  mbedtls_ctr_drbg_free(&_drbg);
+  mbedtls_entropy_free(&_entropy);
+}
+
+int tlsTransport::ssl_send(void *ctx, const unsigned char *buf, size_t len) {
+  nsapi_size_or_error_t ret = static_cast<TCPSocket *>(ctx)->send(buf, len);
+  if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+    return MBEDTLS_ERR_SSL_WANT_WRITE;
+  }
+  return ret;
+}
+
+int tlsTransport::ssl_recv(void *ctx, unsigned char *buf, size_t len) {
+  nsapi_size_or_error_t ret = static_cast<TCPSocket *>(ctx)->recv(buf, len);
+  if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+    return MBEDTLS_ERR_SSL_WANT_READ;
+  }
+  return ret;
+}
+
+int tlsTransport::setup() {
+  int ret = 0;
+  if (_initialized) {
+    return 0;
+  }
+
+  if ((ret = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                                   (const unsigned char *)drbg_pers,
+                                   sizeof(drbg_pers))) != 0) {
+    printf("TLS drbg seed failed: -0x%x\n", -ret);
+    return ret;
+  }
+
+  // set root ca
+  if ((ret = mbedtls_x509_crt_parse(&_cacert,
+                                    (const unsigned char *)root_ca_pem,
+                                    sizeof(root_ca_pem))) != 0) {
+    printf("TLS set CA failed: -0x%x\n", -ret);
+    return ret;
+  }
+
+  if ((ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT,
+                                         MBEDTLS_SSL_TRANSPORT_STREAM,
+                                         MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+    printf("TLS config failed: -0x%x\n", -ret);
+    return ret;
+  }
+  // ssl veryfy is optional
+  mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+  mbedtls_ssl_conf_ca_chain(&_conf, &_cacert, NULL);
+  mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+  if ((ret = mbedtls_ssl_setup(&_ssl, &_conf)) != 0) {
+    printf("TLS setup failed: -0x%x\n", -ret);
+    return ret;
+  }
+  mbedtls_ssl_set_bio(&_ssl, &_tcp, ssl_send, ssl_recv, NULL);
+
+  _initialized = true;
+  return 0;
+}
+
+int tlsTransport::open(NetworkInterface *net, const SocketAddress &addr,
+                       uint32_t timeout_ms) {
+  int ret = 0;
+
+  if ((ret = setup()) != 0) {
+    return ret;
+  }
+
+  // socket open
+  if ((ret = _tcp.open(net)) != NSAPI_ERROR_OK) {
+    printf("TCP socket open failed: %d\n", ret);
+    return ret;
+  }
+  _tcp.set_timeout(timeout_ms);
+  if ((ret = _tcp.connect(addr)) != NSAPI_ERROR_OK) {
+    if (ret == NSAPI_ERROR_WOULD_BLOCK || ret == NSAPI_ERROR_IN_PROGRESS ||
+        ret == NSAPI_ERROR_ALREADY) {
+      // still connecting when the timeout passed
+      ret = NSAPI_ERROR_TIMEOUT;
+    }
+    printf("TCP socket connect failed: %d\n", ret);
+    _tcp.close();
+    return ret;
+  }
+  _port = addr.get_port();
+  return 0;
+}
+
+int tlsTransport::handshake(const char *hostname, tlsSessionCache *cache,
+                            uint32_t timeout_ms) {
+  int ret = 0;
+  bool resuming = false;
+  _resumed = false;
+
+  // a new connection needs a fresh SSL context, the configuration is kept
+  mbedtls_ssl_session_reset(&_ssl);
+  mbedtls_ssl_set_hostname(&_ssl, hostname);
+  if (cache) {
+    resuming = cache->load(hostname, _port, &_ssl) == 0;
+  }
+
+  // drive the handshake step by step, an abbreviated handshake goes from the
+  // server hello straight to change cipher spec without a certificate
+  auto deadline = Kernel::Clock::now() + chrono::milliseconds(timeout_ms);
+  bool full_handshake = false;
+  while (_ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    if (_ssl.state == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+      full_handshake = true;
+    }
+    auto now = Kernel::Clock::now();
+    if (now >= deadline) {
+      ret = NSAPI_ERROR_TIMEOUT;
+    } else {
+      // every step waits at most for the rest of the handshake time
+      _tcp.set_timeout(
+          chrono::duration_cast<chrono::milliseconds>(deadline - now).count());
+      ret = mbedtls_ssl_handshake_step(&_ssl);
+      if (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+          ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        continue;
+      }
+    }
+    if (ret != 0) {
+      printf("TLS handshake failed: -0x%x\n", -ret);
+      if (resuming && cache) {
+        // do not try a session the server rejects again
+        cache->remove(hostname, _port);
+      }
+      _tcp.close();
+      return ret;
+    }
+  }
+  _tcp.set_timeout(_timeout);
+  _resumed = resuming && !full_handshake;
+  if (cache && !_resumed) {
+    cache->save(hostname, _port, &_ssl);
+  }
+  _connected = true;
+  return 0;
+}
+
+nsapi_size_or_error_t tlsTransport::send(const void *data, nsapi_size_t size) {
+  int ret = 0;
+  if (!_connected) {
+    return NSAPI_ERROR_NO_CONNECTION;
+  }
+  ret = mbedtls_ssl_write(&_ssl, (const unsigned char *)data, size);
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+    // a blocking socket only gives up when its timeout passed
+    return _blocking ? NSAPI_ERROR_TIMEOUT : NSAPI_ERROR_WOULD_BLOCK;
+  }
+  return ret < 0 ? NSAPI_ERROR_DEVICE_ERROR : ret;
+}
+
+nsapi_size_or_error_t tlsTransport::recv(void *data, nsapi_size_t size) {
+  if (!_connected) {
+    return NSAPI_ERROR_NO_CONNECTION;
+  }
+  return read_result(mbedtls_ssl_read(&_ssl, (unsigned char *)data, size),
+                     _blocking);
+}
+
+nsapi_size_or_error_t tlsTransport::read_result(int ret, bool blocking) {
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+    // a blocking socket only gives up when its timeout passed
+    return blocking ? NSAPI_ERROR_TIMEOUT : NSAPI_ERROR_WOULD_BLOCK;
+  }
+  if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY ||
+      ret == MBEDTLS_ERR_SSL_CONN_EOF) {
+    // orderly shutdown by the server, with or without close_notify, which
+    // ends a close-delimited body
+    return 0;
+  }
+  return ret < 0 ? NSAPI_ERROR_DEVICE_ERROR : ret;
+}
+
+void tlsTransport::set_blocking(bool blocking) {
+  _blocking = blocking;
+  if (blocking) {
+    _tcp.set_timeout(_timeout);
+  } else {
+    _tcp.set_blocking(false);
+  }
+}
+
+void tlsTransport::set_timeout(int timeout_ms) {
+  _timeout = timeout_ms;
+  if (_blocking) {
+    _tcp.set_timeout(timeout_ms);
+  }
+}
+
+int tlsTransport::random(void *buf, size_t len) {
+  int ret = 0;
+  if ((ret = setup()) != 0) {
+    return ret;
+  }
+  return mbedtls_ctr_drbg_random(&_drbg, (unsigned char *)buf, len);
+}
+
+void tlsTransport::sigio(mbed::Callback<void()> func) { _tcp.sigio(func); }
+
+int tlsTransport::close() {
+  if (_connected) {
+    mbedtls_ssl_close_notify(&_ssl);
+    _connected = false;
+  }
+  _tcp.sigio(nullptr);
+  set_blocking(true);
+  return _tcp.close();
+}
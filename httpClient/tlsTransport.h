@@ -0,0 +1,82 @@
+// Copyright 2021 IOTA Stiftung
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @author Sam Chen
+ * @brief TLS client transport on top of a TCP socket
+ *
+ * A thin mbedTLS client replacing TLSSocket, which gives no access to the SSL
+ * context between mbedtls_ssl_setup() and the first handshake message and so
+ * cannot resume a saved session.
+ */
+
+#ifndef __TLS_TRANSPORT_H__
+#define __TLS_TRANSPORT_H__
+
+#include "mbed.h"
+#include "tlsSessionCache.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+class tlsTransport {
+public:
+  tlsTransport();
+  ~tlsTransport();
+
+  /**
+   * @brief Open a TCP connection
+   *
+   * @param[in] net The network interface
+   * @param[in] addr The server address with port number
+   * @param[in] timeout_ms Time limit of the TCP connect
+   * @return int 0 on success, NSAPI_ERROR_TIMEOUT if the server did not answer
+   */
+  int open(NetworkInterface *net, const SocketAddress &addr,
+           uint32_t timeout_ms);
+
+  /**
+   * @brief Perform the TLS handshake on an open connection
+   *
+   * @param[in] hostname The server name for SNI and certificate checking
+   * @param[in] cache Sessions to resume and keep, NULL for full handshakes
+   * @param[in] timeout_ms Time limit of the whole handshake
+   * @return int 0 on success, NSAPI_ERROR_TIMEOUT if the time limit passed
+   */
+  int handshake(const char *hostname, tlsSessionCache *cache,
+                uint32_t timeout_ms);
+  // in non-blocking mode these return NSAPI_ERROR_WOULD_BLOCK, in blocking
+  // mode NSAPI_ERROR_TIMEOUT once the timeout passed
+  nsapi_size_or_error_t send(const void *data, nsapi_size_t size);
+  nsapi_size_or_error_t recv(void *data, nsapi_size_t size);
+  int close();
+  void set_blocking(bool blocking);
+  void set_timeout(int timeout_ms); // of blocking calls, -1 waits forever
+  void sigio(mbed::Callback<void()> func); // socket state changes
+  int random(void *buf, size_t len);       // from the TLS DRBG
+  bool resumed() { return _resumed; } // last handshake was abbreviated
+  bool connected() { return _connected; }
+  // the result of recv() for a mbedtls_ssl_read() return value
+  static nsapi_size_or_error_t read_result(int ret, bool blocking);
+
+private:
+  static int ssl_send(void *ctx, const unsigned char *buf, size_t len);
+  static int ssl_recv(void *ctx, unsigned char *buf, size_t len);
+  int setup(); // one-time RNG, CA and config init
+
+  TCPSocket _tcp;
+  mbedtls_entropy_context _entropy;
+  mbedtls_ctr_drbg_context _drbg;
+  mbedtls_x509_crt _cacert;
+  mbedtls_ssl_config _conf;
+  mbedtls_ssl_context _ssl;
+  uint16_t _port;
+  int _timeout;
+  bool _initialized;
+  bool _blocking;
+  bool _connected;
+  bool _resumed;
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include <chrono>
 
 #include "NTPClient.h"
+#include "clientpp/batchPublisher.h"
 #include "clientpp/iotaAPI.h"
 #include "jsonUtils.h"
 #include "main_config.h"
@@ -31,7 +32,9 @@ void test_json() {
   vector<string> arr;
 
   cJSON *obj = cJSON_Parse(json_tips);
-  printf("%s\n", cJSON_PrintUnformatted(obj));
+  char *str = cJSON_PrintUnformatted(obj);
+  printf("%s\n", str);
+  cJSON_free(str);
   json.getString(obj, "index", data);
   json.getBool(obj, "isBool", &b);
   json.getArrayString(obj, "arr", arr);
@@ -144,16 +147,29 @@ int main() {
   test_iota_message();
 #endif
   iotaAPI iota;
-  string msg_id;
+
+  // network requests run on their own thread, sampling keeps its own pace
+  EventQueue net_queue;
+  Thread net_thread(osPriorityNormal, HTTP_THREAD_STACK_SIZE, nullptr, "net");
+  net_thread.start(callback(&net_queue, &EventQueue::dispatch_forever));
+  iota.setEventQueue(&net_queue);
+  // samples are sent in batches of BATCH_SAMPLES
+  batchPublisher publisher(iota, &net_queue, "iota_sensor", sensor.id(),
+                           {"temp", "humi"});
 
   // init onboard LED2
   DigitalOut led2(LED2);
 
+  auto next_sample = Kernel::Clock::now();
   while (true) {
     taggle_led(led2);
-    printf("%s\n", sensor.toJSON().c_str());
-    iota.sendIndexation("iota_sensor", sensor.toJSON(), msg_id);
-    ThisThread::sleep_for(chrono::milliseconds(SENSOR_DATA_INTERVAL));
+    float values[] = {sensor.temperature(), sensor.humidity()};
+    printf("temp %.2f, humi %.2f\n", values[0], values[1]);
+    if (publisher.add(time(NULL), values) != 0) {
+      printf("previous batch in progress, sample dropped\n");
+    }
+    next_sample += chrono::milliseconds(SENSOR_DATA_INTERVAL);
+    ThisThread::sleep_until(next_sample);
   }
 }
 
@@ -15,10 +15,45 @@
 #define WIFI_PWD MBED_CONF_APP_WIFI_PASSWORD
 #define WIFI_SECURITY MBED_CONF_APP_WIFI_SECURITY
 #define SENSOR_DATA_INTERVAL MBED_CONF_APP_DATA_INTERVAL
+#define BATCH_SAMPLES MBED_CONF_APP_BATCH_SAMPLES
+#define BATCH_INTERVAL MBED_CONF_APP_BATCH_INTERVAL
+#define BATCH_MAX_BYTES MBED_CONF_APP_BATCH_MAX_BYTES
+
+// iotaAPI
+#define IOTA_SUBMIT_MODE MBED_CONF_APP_SUBMIT_MODE
+#define TIPS_REFRESH_INTERVAL MBED_CONF_APP_TIPS_REFRESH_INTERVAL
+#define TIPS_MAX_AGE MBED_CONF_APP_TIPS_MAX_AGE
+#define MESSAGE_BUF_SIZE MBED_CONF_APP_MESSAGE_BUF
+#define IOTA_LOCAL_POW MBED_CONF_APP_LOCAL_POW
+#define POW_THREADS_MAX MBED_CONF_APP_POW_THREADS
+#define POW_SLICE MBED_CONF_APP_POW_SLICE
+
+// ed25519-donna
+#define ED25519_BATCH_BENCH_MAX MBED_CONF_APP_ED25519_BATCH_BENCH_MAX
+#define ED25519_BATCH_STACK_SIZE MBED_CONF_APP_ED25519_BATCH_STACK
 
 // httpClient
 #define HTTP_BUF_SIZE MBED_CONF_APP_HTTP_BUF
 #define IOTA_NODE_HOST MBED_CONF_APP_HOST
 #define IOTA_NODE_PORT MBED_CONF_APP_PORT
+#define IOTA_NODE_LIST MBED_CONF_APP_NODES
+#define NODE_COOLDOWN MBED_CONF_APP_NODE_COOLDOWN
+#define NODE_PROBE_INTERVAL MBED_CONF_APP_NODE_PROBE_INTERVAL
+#define HTTP_KEEP_ALIVE MBED_CONF_APP_KEEP_ALIVE
+#define HTTP_PIPELINE_DEPTH MBED_CONF_APP_HTTP_PIPELINE_DEPTH
+#define HTTP_CONNECTIONS MBED_CONF_APP_HTTP_CONNECTIONS
+#define HTTP_THREAD_STACK_SIZE MBED_CONF_APP_HTTP_THREAD_STACK
+#define HTTP_CONNECT_TIMEOUT MBED_CONF_APP_HTTP_CONNECT_TIMEOUT
+#define HTTP_HANDSHAKE_TIMEOUT MBED_CONF_APP_HTTP_HANDSHAKE_TIMEOUT
+#define HTTP_FIRST_BYTE_TIMEOUT MBED_CONF_APP_HTTP_FIRST_BYTE_TIMEOUT
+#define HTTP_TOTAL_TIMEOUT MBED_CONF_APP_HTTP_TOTAL_TIMEOUT
+#define HTTP_RETRIES MBED_CONF_APP_HTTP_RETRIES
+#define HTTP_BACKOFF_BASE MBED_CONF_APP_HTTP_BACKOFF_BASE
+#define HTTP_BACKOFF_MAX MBED_CONF_APP_HTTP_BACKOFF_MAX
+#define DNS_CACHE_TTL MBED_CONF_APP_DNS_TTL
+#define DNS_NEGATIVE_TTL MBED_CONF_APP_DNS_NEGATIVE_TTL
+#define TLS_SESSION_RESUME MBED_CONF_APP_TLS_SESSION_RESUME
+#define TLS_SESSION_CACHE_SIZE MBED_CONF_APP_TLS_SESSION_CACHE_SIZE
+#define TLS_SESSION_PERSIST MBED_CONF_APP_TLS_SESSION_PERSIST
 
 #endif
\ No newline at end of file
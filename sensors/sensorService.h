@@ -21,6 +21,7 @@ public:
   std::string toJSON();
   float temperature();
   float humidity();
+  const std::string &id() { return _ID; }
 
 private:
   HTS221 _hts221;